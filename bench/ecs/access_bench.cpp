@@ -0,0 +1,114 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::holds;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+// The entities that hold Position under the benchmark's distribution.
+std::vector<Entity> holders(const std::vector<Entity>& entities, int64_t distribution) {
+  std::vector<Entity> out;
+  for (uint32_t i = 0; i < entities.size(); ++i) {
+    if (holds(distribution, i, 0)) {
+      out.push_back(entities[i]);
+    }
+  }
+  return out;
+}
+
+void BM_WorldAdd(benchmark::State& state) {
+  World world;
+  std::vector<Entity> entities;
+  world.createEntities(static_cast<size_t>(state.range(0)), entities);
+  const std::vector<Entity> targets = holders(entities, state.range(1));
+  for (auto _ : state) {
+    for (const Entity entity : targets) {
+      world.add(entity, Position{1.0f, 2.0f, 3.0f});
+    }
+    state.PauseTiming();
+    for (const Entity entity : targets) {
+      world.remove<Position>(entity);
+    }
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(targets.size()));
+}
+
+void BM_WorldRemove(benchmark::State& state) {
+  World world;
+  std::vector<Entity> entities;
+  world.createEntities(static_cast<size_t>(state.range(0)), entities);
+  const std::vector<Entity> targets = holders(entities, state.range(1));
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (const Entity entity : targets) {
+      world.add(entity, Position{1.0f, 2.0f, 3.0f});
+    }
+    state.ResumeTiming();
+    for (const Entity entity : targets) {
+      world.remove<Position>(entity);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(targets.size()));
+}
+
+void BM_WorldGet(benchmark::State& state) {
+  World world;
+  const std::vector<Entity> targets = holders(populate(world, state.range(0), state.range(1)), state.range(1));
+  const World& read = world;
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const Entity entity : targets) {
+      sum += read.get<Position>(entity).x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(targets.size()));
+}
+
+// Probes every entity, so the sparse rows are mostly misses.
+void BM_WorldHas(benchmark::State& state) {
+  World world;
+  const std::vector<Entity> entities = populate(world, state.range(0), state.range(1));
+  const World& read = world;
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (const Entity entity : entities) {
+      hits += read.has<Position>(entity) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(entities.size()));
+}
+
+// has/get straight on the storage, resolved once: the difference to
+// BM_WorldHas is the per-call storage lookup in World.
+void BM_StorageLookup(benchmark::State& state) {
+  World world;
+  const std::vector<Entity> entities = populate(world, state.range(0), state.range(1));
+  const auto& storage = static_cast<const World&>(world).storage<Position>();
+  for (auto _ : state) {
+    size_t hits = 0;
+    for (const Entity entity : entities) {
+      hits += storage.has(entity) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(entities.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_WorldAdd)->Apply(worldSizes);
+BENCHMARK(BM_WorldRemove)->Apply(worldSizes);
+BENCHMARK(BM_WorldGet)->Apply(worldSizes);
+BENCHMARK(BM_WorldHas)->Apply(worldSizes);
+BENCHMARK(BM_StorageLookup)->Apply(worldSizes);
@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::countMatches;
+using karma::bench::Health;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::setMatchedItems;
+using karma::bench::Velocity;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::StorageMode;
+using karma::ecs::World;
+
+template <StorageMode Mode>
+void BM_JoinThree(benchmark::State& state) {
+  World world(Mode);
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity, Health>(world);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    world.each<const Position, const Velocity, const Health>(
+        [&sum](Entity, const Position& position, const Velocity& velocity, const Health& health) {
+          if (health.value > 0) {
+            sum += position.x * velocity.x;
+          }
+        });
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+template <StorageMode Mode>
+void BM_WriteTwo(benchmark::State& state) {
+  World world(Mode);
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity>(world);
+  for (auto _ : state) {
+    world.each<Position, Velocity>([](Entity, Position& position, Velocity& velocity) {
+      velocity.y -= 0.1f;
+      position.x += velocity.x;
+      position.y += velocity.y;
+      position.z += velocity.z;
+    });
+    benchmark::ClobberMemory();
+  }
+  setMatchedItems(state, matched);
+}
+
+// Moves entities between archetypes (or in and out of a storage) by toggling
+// Velocity.
+template <StorageMode Mode>
+void BM_ToggleComponent(benchmark::State& state) {
+  World world(Mode);
+  const std::vector<Entity> entities = populate(world, state.range(0), state.range(1));
+  constexpr size_t kBatch = 1024;
+  size_t cursor = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < kBatch; ++i) {
+      const Entity entity = entities[(cursor + i) % entities.size()];
+      if (world.has<Velocity>(entity)) {
+        world.remove<Velocity>(entity);
+      } else {
+        world.add(entity, Velocity{});
+      }
+    }
+    cursor += kBatch;
+  }
+  state.SetItemsProcessed(state.iterations() * kBatch);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_JoinThree, StorageMode::SparseSet)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_JoinThree, StorageMode::Archetype)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_WriteTwo, StorageMode::SparseSet)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_WriteTwo, StorageMode::Archetype)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_ToggleComponent, StorageMode::SparseSet)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_ToggleComponent, StorageMode::Archetype)->Apply(worldSizes);
@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::countMatches;
+using karma::bench::Health;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::setMatchedItems;
+using karma::bench::Team;
+using karma::bench::Velocity;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+// A view over Position plus the remaining components; items are the matched
+// entities, and the sparse rows include what skipping non-matches costs.
+template <typename... Rest>
+void BM_ViewArity(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Rest...>(world);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    world.view<const Position, const Rest...>().each(
+        [&sum](Entity, const Position& position, const Rest&...) { sum += position.x; });
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ViewArity<>)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_ViewArity, Velocity)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_ViewArity, Velocity, Health)->Apply(worldSizes);
+BENCHMARK_TEMPLATE(BM_ViewArity, Velocity, Health, Team)->Apply(worldSizes);
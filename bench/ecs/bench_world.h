@@ -0,0 +1,92 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "karma/ecs/world.h"
+
+namespace karma::bench {
+
+// Plain components so that the numbers measure storage, not hooks such as the
+// physics links on Transform.
+struct Position {
+  float x = 0.0f, y = 0.0f, z = 0.0f;
+};
+struct Velocity {
+  float x = 0.0f, y = 0.0f, z = 0.0f;
+};
+struct Health {
+  int32_t value = 100;
+};
+struct Team {
+  uint32_t id = 0;
+};
+
+// Dense: every entity holds every component. Sparse: each entity holds each
+// component with probability 1/4, scattered over the index range, so joins of
+// several components match progressively fewer entities.
+enum Distribution : int64_t { kDense = 0, kSparse = 1 };
+
+inline uint32_t mix(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x7feb352dU;
+  value ^= value >> 15;
+  value *= 0x846ca68bU;
+  value ^= value >> 16;
+  return value;
+}
+
+// Whether entity i holds component slot (0-3) under distribution.
+inline bool holds(int64_t distribution, uint32_t i, uint32_t slot) {
+  return distribution == kDense || mix(i * 4 + slot) % 4 == 0;
+}
+
+// Creates count entities and adds the four components per distribution.
+inline std::vector<ecs::Entity> populate(ecs::World& world, int64_t count, int64_t distribution) {
+  std::vector<ecs::Entity> entities;
+  world.createEntities(static_cast<size_t>(count), entities);
+  for (uint32_t i = 0; i < entities.size(); ++i) {
+    const ecs::Entity entity = entities[i];
+    if (holds(distribution, i, 0)) {
+      world.add(entity, Position{static_cast<float>(i), 0.0f, 0.0f});
+    }
+    if (holds(distribution, i, 1)) {
+      world.add(entity, Velocity{1.0f, 0.0f, 0.0f});
+    }
+    if (holds(distribution, i, 2)) {
+      world.add(entity, Health{});
+    }
+    if (holds(distribution, i, 3)) {
+      world.add(entity, Team{i % 8});
+    }
+  }
+  return entities;
+}
+
+// Entities a join over Ts... visits. Sparse joins match a fraction of the
+// world, so their throughput is reported per matched entity.
+template <typename... Ts>
+int64_t countMatches(ecs::World& world) {
+  int64_t matched = 0;
+  world.each<const Ts...>([&matched](ecs::Entity, const Ts&...) { ++matched; });
+  return matched;
+}
+
+// Items/s over the matched entities, with the match count alongside.
+inline void setMatchedItems(::benchmark::State& state, int64_t matched) {
+  state.counters["matched"] = static_cast<double>(matched);
+  state.SetItemsProcessed(state.iterations() * matched);
+}
+
+// 1k to 1M entities, each dense and sparse.
+inline void worldSizes(::benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"entities", "sparse"});
+  for (const int64_t count : {1'000, 10'000, 100'000, 1'000'000}) {
+    bench->Args({count, kDense});
+    bench->Args({count, kSparse});
+  }
+}
+
+}  // namespace karma::bench
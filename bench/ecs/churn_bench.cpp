@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "bench_world.h"
+#include "karma/ecs/entity_registry.h"
+
+namespace {
+
+using karma::bench::Health;
+using karma::bench::holds;
+using karma::bench::mix;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::Team;
+using karma::bench::Velocity;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::EntityRegistry;
+using karma::ecs::World;
+
+// Steady-state despawn/respawn: each iteration destroys 1% of the live
+// entities at scattered slots and spawns replacements with the same component
+// mix, so the world size and the free list stay level.
+void BM_DestroyChurn(benchmark::State& state) {
+  World world;
+  const int64_t distribution = state.range(1);
+  std::vector<Entity> entities = populate(world, state.range(0), distribution);
+  const size_t batch = std::max<size_t>(entities.size() / 100, 1);
+  uint32_t round = 0;
+  for (auto _ : state) {
+    for (size_t n = 0; n < batch; ++n) {
+      const uint32_t slot = mix(round * static_cast<uint32_t>(batch) + static_cast<uint32_t>(n)) %
+                            static_cast<uint32_t>(entities.size());
+      world.destroyEntity(entities[slot]);
+      const Entity entity = world.createEntity();
+      if (holds(distribution, slot, 0)) {
+        world.add(entity, Position{});
+      }
+      if (holds(distribution, slot, 1)) {
+        world.add(entity, Velocity{});
+      }
+      if (holds(distribution, slot, 2)) {
+        world.add(entity, Health{});
+      }
+      if (holds(distribution, slot, 3)) {
+        world.add(entity, Team{});
+      }
+      entities[slot] = entity;
+    }
+    ++round;
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(batch));
+}
+
+// EntityRegistry alone: destroy and recreate every entity, so each create
+// pops the free list and each destroy bumps a generation.
+void BM_RegistryRecycle(benchmark::State& state) {
+  EntityRegistry registry;
+  std::vector<Entity> entities;
+  registry.create(static_cast<size_t>(state.range(0)), entities);
+  for (auto _ : state) {
+    for (const Entity entity : entities) {
+      registry.destroy(entity);
+    }
+    for (Entity& entity : entities) {
+      entity = registry.create();
+    }
+    benchmark::DoNotOptimize(entities.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_DestroyChurn)->Apply(worldSizes);
+BENCHMARK(BM_RegistryRecycle)->Arg(1'000)->Arg(10'000)->Arg(100'000)->Arg(1'000'000);
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "karma/components/rigidbody.h"
+#include "karma/components/transform.h"
+#include "karma/ecs/command_buffer.h"
+#include "karma/ecs/world.h"
+
+namespace {
+
+using karma::components::RigidbodyComponent;
+using karma::components::TransformComponent;
+using karma::ecs::CommandBuffer;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+// Spawns and then despawns a burst of projectiles each iteration.
+void BM_SpawnDirect(benchmark::State& state) {
+  World world;
+  std::vector<Entity> spawned;
+  for (auto _ : state) {
+    spawned.clear();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      const Entity entity = world.createEntity();
+      world.add(entity, TransformComponent({static_cast<float>(i), 0.0f, 0.0f}));
+      world.add(entity, RigidbodyComponent{});
+      spawned.push_back(entity);
+    }
+    world.destroyEntities(spawned);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SpawnCommandBuffer(benchmark::State& state) {
+  World world;
+  CommandBuffer commands;
+  std::vector<Entity> spawned;
+  for (auto _ : state) {
+    spawned.clear();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      const Entity entity = commands.create();
+      commands.add(entity, TransformComponent({static_cast<float>(i), 0.0f, 0.0f}));
+      commands.add(entity, RigidbodyComponent{});
+    }
+    commands.playback(world);
+    world.each<TransformComponent>([&](Entity entity, TransformComponent&) { spawned.push_back(entity); });
+    world.destroyEntities(spawned);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_SpawnDirect)->Arg(1'000)->Arg(10'000);
+BENCHMARK(BM_SpawnCommandBuffer)->Arg(1'000)->Arg(10'000);
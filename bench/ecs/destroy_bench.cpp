@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::populate;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+// Every other entity, the shape of an end-of-round despawn.
+std::vector<Entity> everyOther(const std::vector<Entity>& entities) {
+  std::vector<Entity> doomed;
+  doomed.reserve(entities.size() / 2 + 1);
+  for (size_t i = 0; i < entities.size(); i += 2) {
+    doomed.push_back(entities[i]);
+  }
+  return doomed;
+}
+
+void BM_DestroyEach(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    World world;
+    const std::vector<Entity> doomed = everyOther(populate(world, state.range(0), state.range(1)));
+    state.ResumeTiming();
+    for (const Entity entity : doomed) {
+      world.destroyEntity(entity);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) / 2);
+}
+
+void BM_DestroyBatch(benchmark::State& state) {
+  for (auto _ : state) {
+    state.PauseTiming();
+    World world;
+    const std::vector<Entity> doomed = everyOther(populate(world, state.range(0), state.range(1)));
+    state.ResumeTiming();
+    world.destroyEntities(doomed);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) / 2);
+}
+
+}  // namespace
+
+BENCHMARK(BM_DestroyEach)->Apply(worldSizes);
+BENCHMARK(BM_DestroyBatch)->Apply(worldSizes);
@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::countMatches;
+using karma::bench::Health;
+using karma::bench::kSparse;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::setMatchedItems;
+using karma::bench::Velocity;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+void BM_JoinView(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity, Health>(world);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    world.view<const Position, const Velocity, const Health>().each(
+        [&sum](Entity, const Position& position, const Velocity& velocity, const Health&) {
+          sum += position.x * velocity.x;
+        });
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+void BM_JoinGroup(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity, Health>(world);
+  auto& group = world.group<Position, Velocity, Health>();
+  for (auto _ : state) {
+    float sum = 0.0f;
+    group.each<const Position, const Velocity, const Health>(
+        [&sum](Entity, const Position& position, const Velocity& velocity, const Health&) {
+          sum += position.x * velocity.x;
+        });
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+// Cost of keeping the group packed: toggle Velocity on a slice of entities.
+void BM_GroupToggle(benchmark::State& state) {
+  World world;
+  const std::vector<Entity> entities = populate(world, 100'000, kSparse);
+  const bool grouped = state.range(0) != 0;
+  if (grouped) {
+    world.group<Position, Velocity, Health>();
+  }
+  for (auto _ : state) {
+    for (size_t i = 0; i < 1024; ++i) {
+      if (world.has<Velocity>(entities[i])) {
+        world.remove<Velocity>(entities[i]);
+      } else {
+        world.add(entities[i], Velocity{});
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 1024);
+}
+
+}  // namespace
+
+BENCHMARK(BM_JoinView)->Apply(worldSizes);
+BENCHMARK(BM_JoinGroup)->Apply(worldSizes);
+BENCHMARK(BM_GroupToggle)->ArgName("grouped")->Arg(0)->Arg(1);
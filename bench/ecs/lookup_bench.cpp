@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "karma/components/rigidbody.h"
+#include "karma/components/transform.h"
+#include "karma/components/visibility.h"
+#include "karma/ecs/world.h"
+
+namespace {
+
+using karma::components::RigidbodyComponent;
+using karma::components::TransformComponent;
+using karma::components::VisibilityComponent;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+// Per-entity World::has/get, the access pattern of systems that do not use
+// views: every call resolves the storage first.
+void BM_WorldHasGet(benchmark::State& state) {
+  World world;
+  std::vector<Entity> entities;
+  for (int i = 0; i < 10'000; ++i) {
+    const Entity entity = world.createEntity();
+    world.add(entity, TransformComponent({static_cast<float>(i), 0.0f, 0.0f}));
+    if (i % 2 == 0) {
+      world.add(entity, VisibilityComponent{});
+    }
+    entities.push_back(entity);
+  }
+  const World& read = world;
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const Entity entity : entities) {
+      if (read.has<VisibilityComponent>(entity) && !read.has<RigidbodyComponent>(entity)) {
+        sum += read.get<TransformComponent>(entity).position().x;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(entities.size()));
+}
+
+}  // namespace
+
+BENCHMARK(BM_WorldHasGet);
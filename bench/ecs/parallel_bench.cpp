@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::countMatches;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::setMatchedItems;
+using karma::bench::Velocity;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::StorageMode;
+using karma::ecs::World;
+
+void integrate(Entity, Position& position, Velocity& velocity) {
+  velocity.y -= 9.8f / 60.0f;
+  position.x += std::sin(velocity.y);
+  position.y += velocity.y / 60.0f;
+  position.z += std::cos(velocity.y);
+}
+
+template <StorageMode Mode>
+void BM_EachSerial(benchmark::State& state) {
+  World world(Mode);
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity>(world);
+  for (auto _ : state) {
+    world.each<Position, Velocity>(integrate);
+    benchmark::ClobberMemory();
+  }
+  setMatchedItems(state, matched);
+}
+
+template <StorageMode Mode>
+void BM_EachParallel(benchmark::State& state) {
+  World world(Mode);
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity>(world);
+  for (auto _ : state) {
+    world.parallelEach<Position, Velocity>(integrate);
+    benchmark::ClobberMemory();
+  }
+  setMatchedItems(state, matched);
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_EachSerial, StorageMode::SparseSet)->Apply(worldSizes)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_EachParallel, StorageMode::SparseSet)->Apply(worldSizes)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_EachSerial, StorageMode::Archetype)->Apply(worldSizes)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_EachParallel, StorageMode::Archetype)->Apply(worldSizes)->UseRealTime();
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <utility>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::Health;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::setMatchedItems;
+using karma::bench::Team;
+using karma::bench::Velocity;
+using karma::bench::worldSizes;
+using karma::ecs::Optional;
+using karma::ecs::With;
+using karma::ecs::Without;
+using karma::ecs::World;
+
+// Entities holding Position and Velocity but not Health, the set both benches
+// resolve, so their items/s compare directly.
+int64_t countQueried(World& world) {
+  int64_t matched = 0;
+  world.query<With<const Position, const Velocity>, Without<Health>>().each(
+      [&matched](auto&&...) { ++matched; });
+  return matched;
+}
+
+// The pre-query pattern: a view plus per-entity World::has/get for the
+// excluded and optional types.
+void BM_ViewWithHasChecks(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countQueried(world);
+  for (auto _ : state) {
+    uint32_t kept = 0;
+    for (auto [entity, position, velocity] : world.view<const Position, const Velocity>().each()) {
+      if (world.has<Health>(entity)) {
+        continue;
+      }
+      if (!world.has<Team>(entity) || std::as_const(world).get<Team>(entity).id != 0) {
+        ++kept;
+      }
+    }
+    benchmark::DoNotOptimize(kept);
+  }
+  setMatchedItems(state, matched);
+}
+
+void BM_QueryWithoutOptional(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countQueried(world);
+  for (auto _ : state) {
+    uint32_t kept = 0;
+    for (auto [entity, position, velocity, team] :
+         world.query<With<const Position, const Velocity>, Without<Health>, Optional<const Team>>()
+             .each()) {
+      if (!team || team->id != 0) {
+        ++kept;
+      }
+    }
+    benchmark::DoNotOptimize(kept);
+  }
+  setMatchedItems(state, matched);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ViewWithHasChecks)->Apply(worldSizes);
+BENCHMARK(BM_QueryWithoutOptional)->Apply(worldSizes);
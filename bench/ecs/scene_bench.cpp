@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "karma/scene/scene.h"
+
+namespace {
+
+using karma::scene::NodeId;
+using karma::scene::Scene;
+
+// count nodes in a tree with fanout 8.
+std::vector<NodeId> buildTree(Scene& scene, int64_t count) {
+  std::vector<NodeId> nodes;
+  for (int64_t i = 0; i < count; ++i) {
+    const NodeId node = scene.createNode();
+    if (i > 0) {
+      scene.reparent(node, nodes[static_cast<size_t>((i - 1) / 8)]);
+    }
+    nodes.push_back(node);
+  }
+  return nodes;
+}
+
+// Moves leaves between parents of a wide tree; the order is re-sorted lazily,
+// so this is the link update alone.
+void BM_SceneReparent(benchmark::State& state) {
+  Scene scene;
+  const std::vector<NodeId> nodes = buildTree(scene, state.range(0));
+  const size_t half = nodes.size() / 2;
+  uint32_t step = 0;
+  for (auto _ : state) {
+    const size_t child = half + step % (nodes.size() - half);
+    scene.reparent(nodes[child], nodes[(step * 7) % half]);
+    ++step;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// One re-sort after a reparent.
+void BM_SceneSort(benchmark::State& state) {
+  Scene scene;
+  const std::vector<NodeId> nodes = buildTree(scene, state.range(0));
+  for (auto _ : state) {
+    scene.reparent(nodes.back(), nodes.front());
+    benchmark::DoNotOptimize(scene.sorted().size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_SceneReparent)->Arg(100'000);
+BENCHMARK(BM_SceneSort)->Arg(10'000)->Arg(100'000);
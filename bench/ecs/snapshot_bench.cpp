@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <string>
+
+#include "karma/components/mesh.h"
+#include "karma/components/rigidbody.h"
+#include "karma/components/tag.h"
+#include "karma/components/transform.h"
+#include "karma/components/visibility.h"
+#include "karma/ecs/snapshot.h"
+
+namespace {
+
+using karma::components::MeshComponent;
+using karma::components::RigidbodyComponent;
+using karma::components::TagComponent;
+using karma::components::TransformComponent;
+using karma::components::VisibilityComponent;
+using karma::ecs::Entity;
+using karma::ecs::SnapshotRegistry;
+using karma::ecs::World;
+
+// Level-shaped content: every entity moves, most render, a few are named.
+void spawnLevel(World& world, int count) {
+  for (int i = 0; i < count; ++i) {
+    const Entity entity = world.createEntity();
+    world.add(entity, TransformComponent({static_cast<float>(i), 0.0f, 0.0f}));
+    world.add(entity, VisibilityComponent{});
+    if (i % 2 == 0) {
+      world.add(entity, RigidbodyComponent{});
+    }
+    if (i % 4 == 0) {
+      MeshComponent mesh;
+      mesh.mesh_key = "meshes/crate_" + std::to_string(i % 16) + ".glb";
+      world.add(entity, std::move(mesh));
+    }
+    if (i % 64 == 0) {
+      world.add(entity, TagComponent{{}, "prop_" + std::to_string(i)});
+    }
+  }
+}
+
+std::filesystem::path snapshotPath() {
+  return std::filesystem::temp_directory_path() / "karma_bench_snapshot.bin";
+}
+
+void BM_LevelRespawn(benchmark::State& state) {
+  for (auto _ : state) {
+    World world;
+    spawnLevel(world, static_cast<int>(state.range(0)));
+    benchmark::DoNotOptimize(world.registry().generations().data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SnapshotSave(benchmark::State& state) {
+  const SnapshotRegistry registry = SnapshotRegistry::engineDefaults();
+  World world;
+  spawnLevel(world, static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    karma::ecs::saveSnapshot(world, registry, snapshotPath());
+  }
+  state.counters["file_KB"] =
+      static_cast<double>(std::filesystem::file_size(snapshotPath())) / 1024.0;
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SnapshotLoad(benchmark::State& state) {
+  const SnapshotRegistry registry = SnapshotRegistry::engineDefaults();
+  {
+    World world;
+    spawnLevel(world, static_cast<int>(state.range(0)));
+    karma::ecs::saveSnapshot(world, registry, snapshotPath());
+  }
+  World world;
+  for (auto _ : state) {
+    karma::ecs::loadSnapshot(world, registry, snapshotPath());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_LevelRespawn)->Arg(100'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SnapshotSave)->Arg(100'000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SnapshotLoad)->Arg(100'000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "karma/ecs/world.h"
+
+namespace {
+
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+struct Marker {
+  uint32_t value = 0;
+};
+
+constexpr int kEntityCount = 1'000'000;
+
+// Occupancy patterns for Marker across kEntityCount entities.
+enum Distribution : int64_t { kLateFew = 0, kEvery64th = 1, kFirstTenth = 2, kAll = 3 };
+
+bool holdsMarker(int64_t distribution, int i) {
+  switch (distribution) {
+    case kLateFew:
+      return i >= kEntityCount - 16;
+    case kEvery64th:
+      return i % 64 == 0;
+    case kFirstTenth:
+      return i < kEntityCount / 10;
+    default:
+      return true;
+  }
+}
+
+void populate(World& world, int64_t distribution) {
+  for (int i = 0; i < kEntityCount; ++i) {
+    const Entity entity = world.createEntity();
+    if (holdsMarker(distribution, i)) {
+      world.add(entity, Marker{static_cast<uint32_t>(i)});
+    }
+  }
+}
+
+// Reports the sparse-side footprint next to what the former flat size_t
+// array would have needed (highest index + 1 entries).
+void BM_SparseFootprint(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0));
+  const auto& storage = world.storage<Marker>();
+  uint32_t highest = 0;
+  for (const Entity entity : storage.denseEntities()) {
+    highest = entity.index > highest ? entity.index : highest;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(storage.sparseBytes());
+  }
+  state.counters["components"] = static_cast<double>(storage.size());
+  state.counters["sparse_KB"] = static_cast<double>(storage.sparseBytes()) / 1024.0;
+  state.counters["flat_KB"] = static_cast<double>(highest + 1) * sizeof(size_t) / 1024.0;
+  state.counters["dense_KB"] = static_cast<double>(storage.denseBytes()) / 1024.0;
+}
+
+// Random-ish has() probes across the whole index range.
+void BM_SparseHas(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0));
+  const auto& storage = world.storage<Marker>();
+  uint32_t index = 0;
+  for (auto _ : state) {
+    int hits = 0;
+    for (int i = 0; i < 4096; ++i) {
+      index = (index * 1664525u + 1013904223u) % kEntityCount;
+      hits += storage.has(Entity{index, 0}) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+  state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+void BM_SparseAddRemove(benchmark::State& state) {
+  World world;
+  populate(world, kAll);
+  for (auto _ : state) {
+    for (uint32_t index = 0; index < 4096; ++index) {
+      world.remove<Marker>(Entity{index * 197, 0});
+    }
+    for (uint32_t index = 0; index < 4096; ++index) {
+      world.add(Entity{index * 197, 0}, Marker{index});
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 8192);
+}
+
+}  // namespace
+
+BENCHMARK(BM_SparseFootprint)->DenseRange(kLateFew, kAll)->Iterations(1);
+BENCHMARK(BM_SparseHas)->DenseRange(kLateFew, kAll);
+BENCHMARK(BM_SparseAddRemove);
@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "karma/components/rigidbody.h"
+#include "karma/components/transform.h"
+#include "karma/components/visibility.h"
+#include "karma/ecs/world.h"
+
+namespace {
+
+using karma::components::RigidbodyComponent;
+using karma::components::TransformComponent;
+using karma::components::VisibilityComponent;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+// A wave of count entities with Transform, Visibility and Rigidbody.
+void BM_SpawnWaveSingle(benchmark::State& state) {
+  const auto count = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    World world;
+    for (int i = 0; i < count; ++i) {
+      const Entity entity = world.createEntity();
+      world.add(entity, TransformComponent({static_cast<float>(i), 0.0f, 0.0f}));
+      world.add(entity, VisibilityComponent{});
+      world.add(entity, RigidbodyComponent{});
+    }
+    benchmark::DoNotOptimize(world.isAlive(Entity{0, 0}));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SpawnWaveBatch(benchmark::State& state) {
+  const auto count = static_cast<int>(state.range(0));
+  std::vector<Entity> entities;
+  std::vector<TransformComponent> transforms;
+  for (auto _ : state) {
+    World world;
+    entities.clear();
+    transforms.clear();
+    world.createEntities(static_cast<size_t>(count), entities);
+    for (int i = 0; i < count; ++i) {
+      transforms.push_back(TransformComponent({static_cast<float>(i), 0.0f, 0.0f}));
+    }
+    world.addBatch<TransformComponent>(entities, transforms);
+    world.emplaceBatch<VisibilityComponent>(entities);
+    world.emplaceBatch<RigidbodyComponent>(entities);
+    benchmark::DoNotOptimize(world.isAlive(Entity{0, 0}));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_SpawnWaveSingle)->Arg(1'000)->Arg(100'000);
+BENCHMARK(BM_SpawnWaveBatch)->Arg(1'000)->Arg(100'000);
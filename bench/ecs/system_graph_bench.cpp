@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+#include "karma/ecs/world.h"
+#include "karma/systems/system_graph.h"
+
+namespace {
+
+using karma::ecs::Entity;
+using karma::ecs::World;
+using karma::systems::ISystem;
+using karma::systems::SystemAccess;
+using karma::systems::SystemGraph;
+using karma::systems::SystemId;
+
+class NoopSystem final : public ISystem {
+ public:
+  std::string_view name() const override { return "noop"; }
+  void update(World&, float dt) override { benchmark::DoNotOptimize(dt); }
+};
+
+// Scheduling overhead of one fixed step: N empty systems where each system
+// depends on the two added before it.
+void BM_SystemGraphUpdate(benchmark::State& state) {
+  World world;
+  SystemGraph graph;
+  const auto count = static_cast<SystemId>(state.range(0));
+  for (SystemId i = 0; i < count; ++i) {
+    const SystemId id = graph.addSystem(std::make_unique<NoopSystem>());
+    for (SystemId dep = id > 2 ? id - 2 : 1; dep < id; ++dep) {
+      graph.addDependency(id, dep);
+    }
+  }
+  for (auto _ : state) {
+    graph.update(world, 1.0f / 120.0f);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <int N>
+struct Lane {
+  float value = 0.0f;
+};
+
+// Integrates its own component over every entity. Declared access lets the
+// graph run all lanes concurrently; range(1) == 0 keeps them exclusive.
+template <int N>
+class LaneSystem final : public ISystem {
+ public:
+  explicit LaneSystem(bool declare_access) : declare_access_(declare_access) {}
+
+  std::string_view name() const override { return "lane"; }
+
+  SystemAccess access() const override {
+    return declare_access_ ? SystemAccess().write<Lane<N>>() : SystemAccess::exclusive();
+  }
+
+  void update(World& world, float dt) override {
+    world.view<Lane<N>>().each([dt](Entity, Lane<N>& lane) { lane.value += lane.value * dt + dt; });
+  }
+
+ private:
+  bool declare_access_;
+};
+
+template <int... Ns>
+void addLanes(World& world, SystemGraph& graph, int count, bool declare_access,
+              std::integer_sequence<int, Ns...>) {
+  for (int i = 0; i < count; ++i) {
+    const Entity entity = world.createEntity();
+    (world.add(entity, Lane<Ns>{}), ...);
+  }
+  (graph.addSystem(std::make_unique<LaneSystem<Ns>>(declare_access)), ...);
+}
+
+void BM_SystemGraphLanes(benchmark::State& state) {
+  World world;
+  SystemGraph graph;
+  addLanes(world, graph, static_cast<int>(state.range(0)), state.range(1) != 0,
+           std::make_integer_sequence<int, 8>{});
+  for (auto _ : state) {
+    graph.update(world, 1.0f / 120.0f);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0) * 8);
+}
+
+}  // namespace
+
+BENCHMARK(BM_SystemGraphUpdate)->Arg(8)->Arg(64);
+BENCHMARK(BM_SystemGraphLanes)->ArgNames({"entities", "declared"})->Args({50'000, 0})->Args({50'000, 1})->UseRealTime();
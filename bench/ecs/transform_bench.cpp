@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "karma/components/transform.h"
+#include "karma/ecs/world.h"
+#include "karma/scene/scene.h"
+#include "karma/systems/transform_system.h"
+
+namespace {
+
+using karma::components::TransformComponent;
+using karma::ecs::Entity;
+using karma::ecs::World;
+using karma::scene::Scene;
+using karma::systems::TransformSystem;
+
+// What each iteration moves before TransformSystem::update.
+enum Dirty : int64_t { kOneLeaf = 0, kTenthOfNodes = 1, kRoot = 2 };
+
+// count entities in a tree with fanout 8, listed parents first.
+std::vector<Entity> buildTree(World& world, Scene& scene, int64_t count) {
+  std::vector<Entity> entities;
+  std::vector<karma::scene::NodeId> nodes;
+  for (int64_t i = 0; i < count; ++i) {
+    const Entity entity = world.createEntity();
+    world.add(entity, TransformComponent({1.0f, 0.0f, 0.0f}, {0.0f, 0.1f, 0.0f, 0.995f}));
+    const auto node = scene.createNode(entity);
+    if (i > 0) {
+      scene.reparent(node, nodes[static_cast<size_t>((i - 1) / 8)]);
+    }
+    entities.push_back(entity);
+    nodes.push_back(node);
+  }
+  return entities;
+}
+
+void BM_TransformPropagate(benchmark::State& state) {
+  World world;
+  Scene scene;
+  TransformSystem system(scene);
+  const std::vector<Entity> entities = buildTree(world, scene, state.range(0));
+  system.update(world, 0.0f);
+  float offset = 0.0f;
+  for (auto _ : state) {
+    offset += 1.0f;
+    switch (state.range(1)) {
+      case kOneLeaf:
+        world.get<TransformComponent>(entities.back()).setPosition({offset, 0.0f, 0.0f});
+        break;
+      case kTenthOfNodes:
+        for (size_t i = 0; i < entities.size(); i += 10) {
+          world.get<TransformComponent>(entities[i]).setPosition({offset, 0.0f, 0.0f});
+        }
+        break;
+      default:
+        world.get<TransformComponent>(entities.front()).setPosition({offset, 0.0f, 0.0f});
+        break;
+    }
+    system.update(world, 0.0f);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_TransformPropagate)
+    ->ArgNames({"entities", "dirty"})
+    ->ArgsProduct({{10'000, 100'000}, {kOneLeaf, kTenthOfNodes, kRoot}});
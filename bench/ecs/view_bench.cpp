@@ -0,0 +1,97 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bench_world.h"
+
+namespace {
+
+using karma::bench::countMatches;
+using karma::bench::Health;
+using karma::bench::populate;
+using karma::bench::Position;
+using karma::bench::setMatchedItems;
+using karma::bench::Velocity;
+using karma::bench::worldSizes;
+using karma::ecs::Entity;
+using karma::ecs::World;
+
+// The pre-View implementation of World::view, kept as the comparison baseline.
+template <typename First, typename... Rest>
+std::vector<Entity> collectEntities(const World& world) {
+  std::vector<Entity> entities;
+  for (const Entity entity : world.storage<First>().denseEntities()) {
+    if (!world.isAlive(entity)) {
+      continue;
+    }
+    if (world.has<First>(entity) && (world.has<Rest>(entity) && ...)) {
+      entities.push_back(entity);
+    }
+  }
+  return entities;
+}
+
+void BM_ViewVector(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity>(world);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const Entity entity : collectEntities<Position, Velocity>(world)) {
+      sum += world.get<Position>(entity).x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+void BM_ViewLazy(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity>(world);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    for (const Entity entity : world.view<const Position, const Velocity>()) {
+      sum += world.get<Position>(entity).x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+void BM_ViewEach(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Velocity>(world);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    auto view = world.view<const Position, const Velocity>();
+    for (auto [entity, position, velocity] : view.each()) {
+      sum += position.x * velocity.x;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+void BM_ViewEachCallback(benchmark::State& state) {
+  World world;
+  populate(world, state.range(0), state.range(1));
+  const int64_t matched = countMatches<Position, Health>(world);
+  for (auto _ : state) {
+    float sum = 0.0f;
+    world.view<const Position, const Health>().each(
+        [&sum](Entity, const Position& position, const Health& health) {
+          sum += position.x * static_cast<float>(health.value);
+        });
+    benchmark::DoNotOptimize(sum);
+  }
+  setMatchedItems(state, matched);
+}
+
+}  // namespace
+
+BENCHMARK(BM_ViewVector)->Apply(worldSizes);
+BENCHMARK(BM_ViewLazy)->Apply(worldSizes);
+BENCHMARK(BM_ViewEach)->Apply(worldSizes);
+BENCHMARK(BM_ViewEachCallback)->Apply(worldSizes);
@@ -0,0 +1,52 @@
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include "demo_game.h"
+
+// Replays a capture from `karma_example --record <path>` headlessly and prints
+// one line per frame (index, milliseconds) followed by a summary on stderr.
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "usage: %s <recording>\n", argv[0]);
+    return 2;
+  }
+
+  karma::app::EngineApp engine;
+  karma::demo::DemoGame game;
+  karma::app::EngineConfig config;
+  config.replay_input_path = argv[1];
+  try {
+    engine.start(game, config);
+  } catch (const std::runtime_error& error) {
+    std::fprintf(stderr, "%s\n", error.what());
+    return 1;
+  }
+  while (engine.isRunning()) {
+    engine.tick();
+  }
+
+  const std::vector<double>& frames = engine.replayFrameSeconds();
+  std::printf("frame,ms\n");
+  for (size_t i = 0; i < frames.size(); ++i) {
+    std::printf("%zu,%.4f\n", i, frames[i] * 1000.0);
+  }
+  if (frames.empty()) {
+    return 0;
+  }
+
+  std::vector<double> sorted = frames;
+  std::sort(sorted.begin(), sorted.end());
+  const auto percentile = [&](double p) {
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(p * static_cast<double>(sorted.size())))];
+  };
+  double total = 0.0;
+  for (const double seconds : frames) {
+    total += seconds;
+  }
+  std::fprintf(stderr, "%zu frames: mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", frames.size(),
+               total / static_cast<double>(frames.size()) * 1000.0, percentile(0.5) * 1000.0,
+               percentile(0.99) * 1000.0, sorted.back() * 1000.0);
+  return 0;
+}
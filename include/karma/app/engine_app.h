@@ -1,11 +1,16 @@
 #pragma once
 
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <memory>
+#include <vector>
 
+#include "karma/app/frame_pacer.h"
 #include "karma/app/game_interface.h"
+#include "karma/app/input_recording.h"
 #include "karma/ecs/world.h"
 #include "karma/input/input_system.h"
 #include "karma/audio/audio.h"
@@ -15,9 +20,12 @@
 #include "karma/physics/physics_world.hpp"
 #include "karma/physics/physics_system.h"
 #include "karma/renderer/device.h"
+#include "karma/renderer/frame_packet.h"
 #include "karma/renderer/render_system.h"
 #include "karma/scene/scene.h"
 #include "karma/systems/system_graph.h"
+#include "karma/systems/transform_system.h"
+#include "karma/tasks/background_job.h"
 
 namespace karma::platform {
 class Window;
@@ -41,6 +49,48 @@ struct EngineConfig {
   int shadow_map_size = 2048;
   float shadow_bias = 0.002f;
   int shadow_pcf_radius = 0;
+  // Submits frame N on the calling thread while frame N+1's fixed steps, game
+  // callbacks and extraction run as one job on a background thread, at the
+  // cost of one frame of latency. Input and the UI stay on the calling thread
+  // and are updated before the job starts; game callbacks must not use the
+  // GraphicsDevice in this mode, since frame N is rendering meanwhile.
+  bool pipelined_rendering = false;
+  // Chrome trace of the profiling zones, written on shutdown when set. Zones
+  // are only recorded in builds with KARMA_ENABLE_PROFILING.
+  std::filesystem::path profile_trace_path;
+  // Dedicated-server mode: no window, renderer, UI or audio. Each tick() waits
+  // for the next fixed_dt deadline, then runs one fixed step followed by
+  // onUpdate(fixed_dt).
+  bool headless = false;
+  // How often headless mode logs HeadlessStats; zero disables the report.
+  float headless_report_interval = 10.0f;
+  // Handed to the game as GameInterface::random_seed; zero picks a random one.
+  // Games that seed their RNGs from it replay deterministically.
+  uint64_t random_seed = 0;
+  // Records each tick's frame dt and window events, plus the seed, and writes
+  // them here on shutdown (see input_recording.h).
+  std::filesystem::path record_input_path;
+  // Replays a recording instead of reading a window: no window, renderer, UI
+  // or audio, and each tick() runs the next recorded frame without waiting.
+  // The app stops after the last frame. Overrides random_seed and fixed_dt.
+  std::filesystem::path replay_input_path;
+};
+
+// Tick pacing counters for headless mode, cumulative since start().
+struct HeadlessStats {
+  uint64_t ticks = 0;
+  // Ticks that took longer than fixed_dt.
+  uint64_t overruns = 0;
+  // Steps dropped after falling more than max_frame_dt behind schedule.
+  uint64_t skipped_steps = 0;
+  double busy_seconds = 0.0;
+  double sleep_seconds = 0.0;
+  double spin_seconds = 0.0;
+  double max_tick_seconds = 0.0;
+
+  double wallSeconds() const { return busy_seconds + sleep_seconds + spin_seconds; }
+  // Share of wall time the thread spent asleep.
+  double idleFraction() const { return wallSeconds() > 0.0 ? sleep_seconds / wallSeconds() : 0.0; }
 };
 
 class EngineApp {
@@ -56,30 +106,63 @@ class EngineApp {
   bool isRunning() const { return running_; }
   void requestStop();
   void setUi(std::unique_ptr<UiLayer> ui);
+  const HeadlessStats& headlessStats() const { return headless_stats_; }
+  // Wall time of each replayed frame, in replay order.
+  const std::vector<double>& replayFrameSeconds() const { return replay_frame_seconds_; }
 
  private:
   void initSubsystems();
   void shutdownSubsystems();
+  void simulate(float frame_dt);
+  void simulatePipelined(float frame_dt);
+  void updateUi(float frame_dt);
+  void renderFrame(float frame_dt, const renderer::FramePacket& packet);
+  void tickHeadless();
+  void reportHeadless();
+  void tickReplay();
+  bool replaying() const { return !config_.replay_input_path.empty(); }
 
   GameInterface* game_ = nullptr;
   std::unique_ptr<platform::Window> window_;
   input::InputSystem input_;
   std::unique_ptr<renderer::GraphicsDevice> graphics_;
   std::unique_ptr<renderer::RenderSystem> render_system_;
-  audio::Audio audio_;
+  std::unique_ptr<audio::Audio> audio_;
   std::unique_ptr<audio::AudioSystem> audio_system_;
   physics::World physics_;
   ecs::World world_;
   scene::Scene scene_;
   systems::SystemGraph systems_;
+  // Owned by systems_, where it runs ahead of physics on every fixed step.
+  // It also runs after the game's onUpdate so extraction sees this frame's
+  // world matrices.
+  systems::TransformSystem* transforms_ = nullptr;
   EngineConfig config_{};
   std::unique_ptr<UiLayer> ui_;
   UIContext ui_context_{};
+  // Double buffer for pipelined rendering: the front packet renders while the
+  // back one is being extracted.
+  std::array<renderer::FramePacket, 2> packets_{};
+  size_t front_packet_ = 0;
+  tasks::BackgroundJob simulation_;
 
   bool running_ = false;
   float fixed_dt_ = 1.0f / 60.0f;
   float accumulator_ = 0.0f;
   std::chrono::steady_clock::time_point last_time_{};
+
+  FramePacer pacer_;
+  std::chrono::steady_clock::time_point next_tick_{};
+  std::chrono::steady_clock::time_point next_report_{};
+  HeadlessStats headless_stats_{};
+  HeadlessStats reported_stats_{};
+  // Slowest tick since the last report; max_tick_seconds covers the whole run.
+  double interval_max_tick_seconds_ = 0.0;
+
+  InputRecording recording_{};
+  InputRecording replay_{};
+  size_t replay_frame_ = 0;
+  std::vector<double> replay_frame_seconds_;
 };
 
 }  // namespace karma::app
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <chrono>
+
+namespace karma::app {
+
+// Waits for tick deadlines without burning a core: sleeps in short slices
+// while the time left exceeds the oversleep the OS has shown so far (mean plus
+// one standard deviation of past slices), then yields until the deadline.
+class FramePacer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Wait {
+    Clock::duration slept{};
+    Clock::duration spun{};
+  };
+
+  Wait waitUntil(Clock::time_point deadline);
+
+ private:
+  void observe(double slice_seconds);
+
+  // Seed with a pessimistic 5 ms so the first waits spin rather than oversleep.
+  double estimate_ = 5e-3;
+  double mean_ = 5e-3;
+  double m2_ = 0.0;
+  double count_ = 1.0;
+};
+
+}  // namespace karma::app
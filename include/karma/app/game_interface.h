@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 #include "karma/ecs/world.h"
 #include "karma/input/input_system.h"
 #include "karma/physics/physics_world.hpp"
@@ -23,16 +25,21 @@ class GameInterface {
   input::InputSystem* input = nullptr;
   physics::World* physics = nullptr;
   renderer::GraphicsDevice* graphics = nullptr;
+  // Seed for game-side randomness; recorded with input captures so replays
+  // make the same choices.
+  uint64_t random_seed = 0;
 
  private:
   friend class EngineApp;
   void bindContext(ecs::World& world, scene::Scene& scene, input::InputSystem& input,
-                   physics::World& physics, renderer::GraphicsDevice* graphics) {
+                   physics::World& physics, renderer::GraphicsDevice* graphics,
+                   uint64_t random_seed) {
     this->world = &world;
     this->scene = &scene;
     this->input = &input;
     this->physics = &physics;
     this->graphics = graphics;
+    this->random_seed = random_seed;
   }
 };
 
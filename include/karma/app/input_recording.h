@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "karma/platform/events.h"
+
+namespace karma::app {
+
+// What one EngineApp::tick took from outside the simulation: the clamped frame
+// dt and the window events handed to InputSystem::update.
+struct RecordedFrame {
+  float dt = 0.0f;
+  std::vector<platform::Event> events;
+};
+
+// A captured session. Replaying it with the same build, assets and seed
+// reproduces the session's simulation frame for frame.
+struct InputRecording {
+  uint64_t seed = 0;
+  float fixed_dt = 1.0f / 60.0f;
+  std::vector<RecordedFrame> frames;
+};
+
+// Binary format: a header (magic, version, seed, fixed_dt, frame count), then
+// per frame its dt, event count and events. Each event stores only the fields
+// its type uses. Both throw std::runtime_error on I/O errors; loading also
+// throws on files that are not recordings or are truncated.
+void saveInputRecording(const InputRecording& recording, const std::filesystem::path& path);
+InputRecording loadInputRecording(const std::filesystem::path& path);
+
+}  // namespace karma::app
@@ -1,12 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <limits>
 #include <string_view>
 #include <unordered_map>
+#include <vector>
 
 #include "karma/audio/audio.h"
 #include "karma/components/audio_source.h"
 #include "karma/components/audio_listener.h"
 #include "karma/components/transform.h"
+#include "karma/components/world_matrix.h"
 #include "karma/ecs/world.h"
 #include "karma/systems/system.h"
 
@@ -18,18 +22,31 @@ class AudioSystem final : public systems::ISystem {
 
   std::string_view name() const override { return "AudioSystem"; }
   void update(ecs::World& world, float dt) override;
-
- private:
-  static uint64_t entityKey(ecs::Entity entity) {
-    return (static_cast<uint64_t>(entity.index) << 32) |
-           static_cast<uint64_t>(entity.generation);
+  // The audio device is only driven from here.
+  systems::SystemAccess access() const override {
+    return systems::SystemAccess()
+        .read<components::AudioListenerComponent, components::TransformComponent,
+              components::WorldMatrixComponent>()
+        .write<components::AudioSourceComponent>();
   }
 
+ private:
+  void bind(ecs::World& world);
+  void queueStart(ecs::Entity entity);
+  void dequeueStart(ecs::Entity entity);
+  bool playSource(const components::AudioSourceComponent& source, const math::Vec3& pos);
   AudioClip& getClip(const std::string& key, int max_instances);
 
   Audio& audio_;
   std::unordered_map<std::string, AudioClip> clip_cache_;
-  std::unordered_map<uint64_t, bool> played_on_start_;
+  ecs::World* bound_world_ = nullptr;
+  std::vector<ecs::Connection> connections_;
+  static constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+
+  // Sources constructed with play_on_start that have not played yet.
+  std::vector<ecs::Entity> pending_start_;
+  // Entity index -> position in pending_start_, kNoSlot when not queued.
+  std::vector<uint32_t> pending_slot_;
   bool warned_multiple_listeners_ = false;
   bool warned_no_listener_ = false;
 };
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "karma/ecs/component.h"
+#include "karma/math/types.h"
+
+namespace karma::components {
+
+// Pose an entity had before the latest fixed step. PhysicsSystem keeps it on
+// dynamic bodies; RenderSystem draws those bodies between this pose and the
+// TransformComponent, so rendering can run faster than the simulation.
+struct PreviousTransformComponent : ecs::ComponentTag {
+  math::Vec3 position{};
+  math::Quat rotation{};
+};
+
+}  // namespace karma::components
@@ -21,6 +21,8 @@ class RigidbodyComponent : public ecs::ComponentTag {
 
   math::Vec3 getPosition() const { return position_; }
 
+  bool hasPendingTeleport() const { return teleport_; }
+
   bool consumeTeleport(math::Vec3& out_position) {
     if (!teleport_) {
       return false;
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "karma/components/transform.h"
+#include "karma/ecs/component.h"
+#include "karma/ecs/component_storage.h"
+#include "karma/math/mat4.h"
+
+namespace karma::components {
+
+// Cached local-to-world matrix, maintained by systems::TransformSystem for
+// every entity with a TransformComponent. Scene node entities compose their
+// TransformComponent with their parent's matrix; entities outside the scene
+// use it as is. Read-only outside TransformSystem.
+struct WorldMatrixComponent : ecs::ComponentTag {
+  math::Mat4 matrix{};
+};
+
+struct WorldPose {
+  math::Vec3 position{};
+  math::Quat rotation{};
+};
+
+// The cached world matrix when TransformSystem has produced one, so entities
+// follow their scene ancestors; the TransformComponent otherwise.
+inline WorldPose worldPose(const ecs::ComponentStorage<WorldMatrixComponent>& matrices,
+                           ecs::Entity entity,
+                           const TransformComponent& transform) {
+  if (!matrices.has(entity)) {
+    return {transform.position(), transform.rotation()};
+  }
+  const math::Mat4& matrix = matrices.get(entity).matrix;
+  return {math::translation(matrix), math::rotationOf(matrix)};
+}
+
+}  // namespace karma::components
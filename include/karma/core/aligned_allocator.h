@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace karma::core {
+
+inline constexpr size_t kCacheLineSize = 64;
+
+template <typename T, size_t Alignment = kCacheLineSize>
+struct AlignedAllocator {
+  static_assert(Alignment >= alignof(T), "Alignment must satisfy the type's alignment.");
+
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() noexcept = default;
+
+  template <typename U>
+  AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+  T* allocate(size_t count) {
+    return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+  }
+
+  void deallocate(T* ptr, size_t) noexcept {
+    ::operator delete(ptr, std::align_val_t{Alignment});
+  }
+
+  template <typename U>
+  friend bool operator==(const AlignedAllocator&, const AlignedAllocator<U, Alignment>&) {
+    return true;
+  }
+};
+
+}  // namespace karma::core
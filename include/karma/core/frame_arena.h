@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace karma::core {
+
+// Bump allocator for data that lives no longer than a frame. allocate()
+// advances an offset into one block, deallocate() only takes back the most
+// recent allocation and reset() rewinds the block. Requests that do not fit go
+// to the heap; the next reset() then swaps in a single block large enough for
+// that frame, so a steady workload stops touching the heap after its first few
+// frames.
+class FrameArena {
+ public:
+  static constexpr size_t kDefaultCapacity = size_t{256} << 10;
+
+  explicit FrameArena(size_t capacity = kDefaultCapacity);
+
+  FrameArena(const FrameArena&) = delete;
+  FrameArena& operator=(const FrameArena&) = delete;
+
+  void* allocate(size_t size, size_t alignment);
+  void deallocate(void* ptr, size_t size) noexcept;
+  // Invalidates everything allocated since the previous reset.
+  void reset();
+
+  size_t capacity() const { return capacity_.load(std::memory_order_relaxed); }
+  // Bytes handed out since the last reset, alignment padding included.
+  size_t used() const { return offset_ + overflow_bytes_; }
+  // Largest used() of any frame so far.
+  size_t highWater() const { return high_water_.load(std::memory_order_relaxed); }
+  // Allocations that did not fit the block and went to the heap.
+  size_t overflowCount() const { return overflow_count_.load(std::memory_order_relaxed); }
+
+ private:
+  std::unique_ptr<std::byte[]> block_;
+  size_t offset_ = 0;
+  size_t overflow_bytes_ = 0;
+  std::vector<std::unique_ptr<std::byte[]>> overflow_;
+  // Atomic so frameArenaStats() can read them from another thread.
+  std::atomic<size_t> capacity_{0};
+  std::atomic<size_t> high_water_{0};
+  std::atomic<size_t> overflow_count_{0};
+};
+
+// The calling thread's arena. The first call after resetFrameArenas() resets
+// it, so memory from it must not be kept past the end of the frame.
+FrameArena& frameArena();
+
+// Starts a new frame for every thread's arena. Call it between frames, while
+// no thread still uses memory from the previous one.
+void resetFrameArenas();
+
+struct FrameArenaStats {
+  size_t threads = 0;
+  size_t capacity_bytes = 0;
+  // Sum of the per-thread high-water marks.
+  size_t high_water_bytes = 0;
+  size_t overflow_count = 0;
+};
+
+FrameArenaStats frameArenaStats();
+
+// STL allocator over a FrameArena, by default the constructing thread's.
+// Containers using it must be destroyed before their arena resets, and only
+// the arena's thread may grow or destroy them.
+template <typename T>
+class FrameAllocator {
+ public:
+  using value_type = T;
+
+  FrameAllocator() : arena_(&frameArena()) {}
+  explicit FrameAllocator(FrameArena& arena) noexcept : arena_(&arena) {}
+
+  template <typename U>
+  FrameAllocator(const FrameAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+  T* allocate(size_t count) {
+    if (count > std::numeric_limits<size_t>::max() / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, size_t count) noexcept { arena_->deallocate(ptr, count * sizeof(T)); }
+
+  FrameArena* arena() const noexcept { return arena_; }
+
+  template <typename U>
+  friend bool operator==(const FrameAllocator& a, const FrameAllocator<U>& b) noexcept {
+    return a.arena_ == b.arena();
+  }
+
+ private:
+  FrameArena* arena_;
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+}  // namespace karma::core
@@ -1,17 +1,19 @@
 #pragma once
 
-#include <cstdint>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 
 namespace karma::core {
 
 using TypeId = uint32_t;
 
 inline TypeId nextTypeId() {
-  static TypeId counter = 1;
-  return counter++;
+  static std::atomic<TypeId> counter{1};
+  return counter.fetch_add(1, std::memory_order_relaxed);
 }
 
+// Dense per-type id, assigned on first use. Safe to call from any thread.
 template <typename T>
 TypeId typeId() {
   static const TypeId id = nextTypeId();
@@ -0,0 +1,426 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "karma/core/type_id.h"
+#include "karma/ecs/entity.h"
+
+namespace karma::ecs {
+
+enum class StorageMode {
+  SparseSet,
+  Archetype
+};
+
+struct ComponentInfo {
+  core::TypeId id = 0;
+  size_t size = 0;
+  size_t align = 0;
+  void (*move_construct)(void* dst, void* src) = nullptr;
+  void (*destroy)(void* ptr) = nullptr;
+};
+
+template <typename T>
+const ComponentInfo& componentInfo() {
+  static const ComponentInfo info{
+      core::typeId<T>(),
+      sizeof(T),
+      alignof(T),
+      [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); },
+      [](void* ptr) { static_cast<T*>(ptr)->~T(); }};
+  return info;
+}
+
+// Groups entities by component signature. Each archetype owns fixed-size chunks
+// laid out as structure-of-arrays: an entity column followed by one column per
+// component type, so multi-component queries are linear scans over chunks.
+class ArchetypeStorage {
+ public:
+  static constexpr size_t kChunkBytes = 16 * 1024;
+
+  ArchetypeStorage() = default;
+  ~ArchetypeStorage() { clear(); }
+
+  ArchetypeStorage(const ArchetypeStorage&) = delete;
+  ArchetypeStorage& operator=(const ArchetypeStorage&) = delete;
+
+  template <typename T>
+  bool has(Entity entity) const {
+    const Location* location = find(entity);
+    return location && archetypes_[location->archetype]->column(core::typeId<T>()) >= 0;
+  }
+
+  template <typename T>
+  T& get(Entity entity) {
+    const Location& location = locations_[entity.index];
+    Archetype& archetype = *archetypes_[location.archetype];
+    const int column = archetype.column(core::typeId<T>());
+    return *static_cast<T*>(archetype.slot(location.chunk, location.row, column));
+  }
+
+  template <typename T>
+  const T& get(Entity entity) const {
+    return const_cast<ArchetypeStorage*>(this)->get<T>(entity);
+  }
+
+  template <typename T>
+  void add(Entity entity, T component) {
+    const ComponentInfo& info = componentInfo<T>();
+    const Location* location = find(entity);
+    if (location) {
+      Archetype& current = *archetypes_[location->archetype];
+      const int column = current.column(info.id);
+      if (column >= 0) {
+        *static_cast<T*>(current.slot(location->chunk, location->row, column)) =
+            std::move(component);
+        return;
+      }
+    }
+
+    const uint32_t target = location ? addEdge(location->archetype, info)
+                                     : archetypeFor({&info});
+    const Location moved = moveEntity(entity, target);
+    Archetype& archetype = *archetypes_[target];
+    new (archetype.slot(moved.chunk, moved.row, archetype.column(info.id))) T(std::move(component));
+  }
+
+  template <typename T>
+  void remove(Entity entity) {
+    const Location* location = find(entity);
+    if (!location) {
+      return;
+    }
+    const core::TypeId id = core::typeId<T>();
+    if (archetypes_[location->archetype]->column(id) < 0) {
+      return;
+    }
+    const uint32_t target = removeEdge(location->archetype, id);
+    if (archetypes_[target]->infos.empty()) {
+      destroy(entity);
+      return;
+    }
+    moveEntity(entity, target);
+  }
+
+  void destroy(Entity entity) {
+    const Location* location = find(entity);
+    if (!location) {
+      return;
+    }
+    const Location old = *location;
+    Archetype& archetype = *archetypes_[old.archetype];
+    for (size_t column = 0; column < archetype.infos.size(); ++column) {
+      archetype.infos[column]->destroy(archetype.slot(old.chunk, old.row, column));
+    }
+    removeRow(old);
+    locations_[entity.index] = Location{};
+  }
+
+  // Calls func(Entity, Ts&...) for every entity whose archetype contains all Ts.
+  template <typename... Ts, typename Func>
+  void each(Func&& func) {
+    static_assert(sizeof...(Ts) > 0, "each requires at least one component type.");
+    std::array<core::TypeId, sizeof...(Ts)> query{core::typeId<std::remove_const_t<Ts>>()...};
+    std::sort(query.begin(), query.end());
+    for (const auto& archetype_ptr : archetypes_) {
+      Archetype& archetype = *archetype_ptr;
+      if (archetype.chunks.empty() ||
+          !std::includes(archetype.types.begin(), archetype.types.end(),
+                         query.begin(), query.end())) {
+        continue;
+      }
+      const size_t columns[] = {
+          static_cast<size_t>(archetype.column(core::typeId<std::remove_const_t<Ts>>()))...};
+      for (uint32_t chunk = 0; chunk < archetype.chunks.size(); ++chunk) {
+        eachInChunk<Ts...>(archetype, chunk, columns, func, std::index_sequence_for<Ts...>{});
+      }
+    }
+  }
+
+  struct ChunkRef {
+    uint32_t archetype = 0;
+    uint32_t chunk = 0;
+  };
+
+  // Appends every chunk whose archetype contains all Ts; chunks are independent
+  // units of work for parallel iteration.
+  template <typename... Ts, typename Out>
+  void matchChunks(Out& out) const {
+    std::array<core::TypeId, sizeof...(Ts)> query{core::typeId<std::remove_const_t<Ts>>()...};
+    std::sort(query.begin(), query.end());
+    for (uint32_t index = 0; index < archetypes_.size(); ++index) {
+      const Archetype& archetype = *archetypes_[index];
+      if (!std::includes(archetype.types.begin(), archetype.types.end(),
+                         query.begin(), query.end())) {
+        continue;
+      }
+      for (uint32_t chunk = 0; chunk < archetype.chunks.size(); ++chunk) {
+        out.push_back(ChunkRef{index, chunk});
+      }
+    }
+  }
+
+  template <typename... Ts, typename Func>
+  void eachInChunk(ChunkRef ref, Func&& func) {
+    Archetype& archetype = *archetypes_[ref.archetype];
+    const size_t columns[] = {
+        static_cast<size_t>(archetype.column(core::typeId<std::remove_const_t<Ts>>()))...};
+    eachInChunk<Ts...>(archetype, ref.chunk, columns, func, std::index_sequence_for<Ts...>{});
+  }
+
+  size_t archetypeCount() const { return archetypes_.size(); }
+
+  size_t chunkCount() const {
+    size_t count = 0;
+    for (const auto& archetype : archetypes_) {
+      count += archetype->chunks.size();
+    }
+    return count;
+  }
+
+  void clear() {
+    for (auto& archetype_ptr : archetypes_) {
+      Archetype& archetype = *archetype_ptr;
+      for (uint32_t chunk = 0; chunk < archetype.chunks.size(); ++chunk) {
+        for (uint32_t row = 0; row < archetype.chunks[chunk].count; ++row) {
+          for (size_t column = 0; column < archetype.infos.size(); ++column) {
+            archetype.infos[column]->destroy(archetype.slot(chunk, row, column));
+          }
+        }
+      }
+      archetype.chunks.clear();
+    }
+    locations_.clear();
+  }
+
+ private:
+  static constexpr uint32_t kNoArchetype = 0xFFFFFFFFu;
+
+  struct ChunkDeleter {
+    void operator()(std::byte* data) const {
+      ::operator delete(data, std::align_val_t{64});
+    }
+  };
+
+  struct Chunk {
+    std::unique_ptr<std::byte, ChunkDeleter> data;
+    uint32_t count = 0;
+  };
+
+  struct Archetype {
+    std::vector<core::TypeId> types;
+    std::vector<const ComponentInfo*> infos;
+    std::vector<size_t> offsets;
+    size_t chunk_bytes = kChunkBytes;
+    uint32_t capacity = 0;
+    std::vector<Chunk> chunks;
+    std::unordered_map<core::TypeId, uint32_t> add_edges;
+    std::unordered_map<core::TypeId, uint32_t> remove_edges;
+
+    int column(core::TypeId id) const {
+      const auto it = std::lower_bound(types.begin(), types.end(), id);
+      if (it == types.end() || *it != id) {
+        return -1;
+      }
+      return static_cast<int>(it - types.begin());
+    }
+
+    Entity* entities(uint32_t chunk) {
+      return reinterpret_cast<Entity*>(chunks[chunk].data.get());
+    }
+
+    void* slot(uint32_t chunk, uint32_t row, size_t column) {
+      return chunks[chunk].data.get() + offsets[column] + row * infos[column]->size;
+    }
+  };
+
+  struct Location {
+    uint32_t archetype = kNoArchetype;
+    uint32_t chunk = 0;
+    uint32_t row = 0;
+  };
+
+  static size_t alignUp(size_t value, size_t align) {
+    return (value + align - 1) & ~(align - 1);
+  }
+
+  static size_t layout(Archetype& archetype, uint32_t capacity) {
+    size_t offset = sizeof(Entity) * capacity;
+    archetype.offsets.resize(archetype.infos.size());
+    for (size_t column = 0; column < archetype.infos.size(); ++column) {
+      offset = alignUp(offset, archetype.infos[column]->align);
+      archetype.offsets[column] = offset;
+      offset += archetype.infos[column]->size * capacity;
+    }
+    return offset;
+  }
+
+  const Location* find(Entity entity) const {
+    if (entity.index >= locations_.size()) {
+      return nullptr;
+    }
+    const Location& location = locations_[entity.index];
+    if (location.archetype == kNoArchetype) {
+      return nullptr;
+    }
+    Archetype& archetype = *archetypes_[location.archetype];
+    if (archetype.entities(location.chunk)[location.row] != entity) {
+      return nullptr;
+    }
+    return &location;
+  }
+
+  uint32_t archetypeFor(std::vector<const ComponentInfo*> infos) {
+    std::sort(infos.begin(), infos.end(),
+              [](const ComponentInfo* a, const ComponentInfo* b) { return a->id < b->id; });
+    std::vector<core::TypeId> types;
+    types.reserve(infos.size());
+    for (const ComponentInfo* info : infos) {
+      types.push_back(info->id);
+    }
+    const auto it = archetype_lookup_.find(types);
+    if (it != archetype_lookup_.end()) {
+      return it->second;
+    }
+
+    auto archetype = std::make_unique<Archetype>();
+    archetype->types = types;
+    archetype->infos = std::move(infos);
+    size_t row_bytes = sizeof(Entity);
+    for (const ComponentInfo* info : archetype->infos) {
+      row_bytes += info->size;
+    }
+    uint32_t capacity = static_cast<uint32_t>(std::max<size_t>(1, kChunkBytes / row_bytes));
+    while (capacity > 1 && layout(*archetype, capacity) > kChunkBytes) {
+      --capacity;
+    }
+    archetype->capacity = capacity;
+    archetype->chunk_bytes = std::max(kChunkBytes, layout(*archetype, capacity));
+
+    const uint32_t index = static_cast<uint32_t>(archetypes_.size());
+    archetypes_.push_back(std::move(archetype));
+    archetype_lookup_.emplace(std::move(types), index);
+    return index;
+  }
+
+  uint32_t addEdge(uint32_t from, const ComponentInfo& info) {
+    auto& edges = archetypes_[from]->add_edges;
+    const auto it = edges.find(info.id);
+    if (it != edges.end()) {
+      return it->second;
+    }
+    std::vector<const ComponentInfo*> infos = archetypes_[from]->infos;
+    infos.push_back(&info);
+    const uint32_t target = archetypeFor(std::move(infos));
+    archetypes_[from]->add_edges.emplace(info.id, target);
+    return target;
+  }
+
+  uint32_t removeEdge(uint32_t from, core::TypeId id) {
+    auto& edges = archetypes_[from]->remove_edges;
+    const auto it = edges.find(id);
+    if (it != edges.end()) {
+      return it->second;
+    }
+    std::vector<const ComponentInfo*> infos;
+    for (const ComponentInfo* info : archetypes_[from]->infos) {
+      if (info->id != id) {
+        infos.push_back(info);
+      }
+    }
+    const uint32_t target = archetypeFor(std::move(infos));
+    archetypes_[from]->remove_edges.emplace(id, target);
+    return target;
+  }
+
+  Location allocateRow(uint32_t index) {
+    Archetype& archetype = *archetypes_[index];
+    if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity) {
+      Chunk chunk;
+      chunk.data.reset(static_cast<std::byte*>(
+          ::operator new(archetype.chunk_bytes, std::align_val_t{64})));
+      archetype.chunks.push_back(std::move(chunk));
+    }
+    const uint32_t chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+    return Location{index, chunk, archetype.chunks[chunk].count++};
+  }
+
+  // Moves every component the entity already has into a fresh row of the target
+  // archetype. Columns only present in the target are left unconstructed.
+  Location moveEntity(Entity entity, uint32_t target) {
+    if (entity.index >= locations_.size()) {
+      locations_.resize(entity.index + 1);
+    }
+    const Location* current = find(entity);
+    const Location destination = allocateRow(target);
+    Archetype& to = *archetypes_[target];
+    to.entities(destination.chunk)[destination.row] = entity;
+
+    if (current) {
+      const Location old = *current;
+      Archetype& from = *archetypes_[old.archetype];
+      for (size_t column = 0; column < from.infos.size(); ++column) {
+        void* src = from.slot(old.chunk, old.row, column);
+        const int to_column = to.column(from.infos[column]->id);
+        if (to_column >= 0) {
+          from.infos[column]->move_construct(
+              to.slot(destination.chunk, destination.row, to_column), src);
+        }
+        from.infos[column]->destroy(src);
+      }
+      removeRow(old);
+    }
+    locations_[entity.index] = destination;
+    return destination;
+  }
+
+  // Fills the hole left at `location` (already destroyed) with the archetype's last row.
+  void removeRow(const Location& location) {
+    Archetype& archetype = *archetypes_[location.archetype];
+    const uint32_t last_chunk = static_cast<uint32_t>(archetype.chunks.size() - 1);
+    const uint32_t last_row = archetype.chunks[last_chunk].count - 1;
+    if (location.chunk != last_chunk || location.row != last_row) {
+      const Entity moved = archetype.entities(last_chunk)[last_row];
+      for (size_t column = 0; column < archetype.infos.size(); ++column) {
+        void* src = archetype.slot(last_chunk, last_row, column);
+        archetype.infos[column]->move_construct(
+            archetype.slot(location.chunk, location.row, column), src);
+        archetype.infos[column]->destroy(src);
+      }
+      archetype.entities(location.chunk)[location.row] = moved;
+      locations_[moved.index] = location;
+    }
+    if (--archetype.chunks[last_chunk].count == 0) {
+      archetype.chunks.pop_back();
+    }
+  }
+
+  template <typename... Ts, typename Func, size_t... Is>
+  void eachInChunk(Archetype& archetype, uint32_t chunk, const size_t* columns, Func& func,
+                   std::index_sequence<Is...>) {
+    const Entity* entities = archetype.entities(chunk);
+    const uint32_t count = archetype.chunks[chunk].count;
+    std::byte* data = archetype.chunks[chunk].data.get();
+    auto arrays = std::make_tuple(
+        reinterpret_cast<std::remove_const_t<Ts>*>(data + archetype.offsets[columns[Is]])...);
+    for (uint32_t row = 0; row < count; ++row) {
+      func(entities[row], static_cast<Ts&>(std::get<Is>(arrays)[row])...);
+    }
+  }
+
+  std::vector<std::unique_ptr<Archetype>> archetypes_;
+  std::map<std::vector<core::TypeId>, uint32_t> archetype_lookup_;
+  std::vector<Location> locations_;
+};
+
+}  // namespace karma::ecs
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "karma/ecs/entity.h"
+
+namespace karma::ecs {
+
+class World;
+
+// Records structural changes (create/add/remove/destroy) for later playback on
+// the owning thread. Component payloads live in a linear arena whose blocks are
+// kept across playbacks, so steady-state recording does not allocate. A buffer
+// is not thread-safe; give each thread or parallel chunk its own.
+//
+// playback() applies, in order: all creates, then adds/removes in recorded order
+// (storages are reserved once per type up front), then all destroys as one
+// World::destroyEntities batch.
+class CommandBuffer {
+ public:
+  CommandBuffer() : tag_(nextTag()) {}
+  ~CommandBuffer() { clear(); }
+
+  // Recorded commands and placeholders move with the buffer; a moved-into
+  // buffer drops whatever it had recorded first.
+  CommandBuffer(CommandBuffer&& other) noexcept;
+  CommandBuffer& operator=(CommandBuffer&& other) noexcept;
+  CommandBuffer(const CommandBuffer&) = delete;
+  CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+  // Returns a placeholder that add/remove/destroy on this buffer accept. It
+  // becomes a real entity only during playback. Placeholders carry the
+  // buffer's tag in their generation; passing one to another buffer, or to
+  // this buffer after playback() or clear(), throws std::logic_error.
+  Entity create() {
+    return Entity{pending_count_++, tag_};
+  }
+
+  template <typename T>
+  void add(Entity entity, T component) {
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "CommandBuffer does not support over-aligned components.");
+    checkOwned(entity);
+    void* payload = allocate(sizeof(T), alignof(T));
+    ::new (payload) T(std::move(component));
+    commands_.push_back(Command{entity, payload, &applyAdd<World, T>, &destroyPayload<T>,
+                                &reserveAdds<World, T>});
+  }
+
+  template <typename T>
+  void remove(Entity entity) {
+    checkOwned(entity);
+    commands_.push_back(Command{entity, nullptr, &applyRemove<World, T>, nullptr, nullptr});
+  }
+
+  void destroy(Entity entity) {
+    checkOwned(entity);
+    destroyed_.push_back(entity);
+  }
+
+  bool empty() const { return commands_.empty() && destroyed_.empty() && pending_count_ == 0; }
+
+  void playback(World& world);
+
+  // Drops every recorded command and retires outstanding placeholders; arena
+  // blocks are kept for reuse.
+  void clear();
+
+ private:
+  using ApplyFn = void (*)(World&, Entity, void*);
+  using DestroyFn = void (*)(void*);
+  using ReserveFn = void (*)(World&, size_t);
+
+  struct Command {
+    Entity entity;
+    void* payload;
+    ApplyFn apply;
+    DestroyFn destroy;
+    ReserveFn reserve;
+  };
+
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size = 0;
+  };
+
+  // Placeholder generations have the top byte set and the buffer's tag below;
+  // live entities never get that far.
+  static constexpr uint32_t kPendingMask = 0xFF000000u;
+  static constexpr size_t kBlockSize = 16 * 1024;
+
+  static bool isPending(Entity entity) { return (entity.generation & kPendingMask) == kPendingMask; }
+  static uint32_t nextTag();
+
+  template <typename W, typename T>
+  static void applyAdd(W& world, Entity entity, void* payload) {
+    world.add(entity, std::move(*static_cast<T*>(payload)));
+  }
+
+  template <typename W, typename T>
+  static void applyRemove(W& world, Entity entity, void*) {
+    world.template remove<T>(entity);
+  }
+
+  template <typename W, typename T>
+  static void reserveAdds(W& world, size_t count) {
+    world.template reserve<T>(count);
+  }
+
+  template <typename T>
+  static void destroyPayload(void* payload) {
+    static_cast<T*>(payload)->~T();
+  }
+
+  void* allocate(size_t size, size_t alignment);
+  void checkOwned(Entity entity) const {
+    if (isPending(entity) && (entity.generation != tag_ || entity.index >= pending_count_)) {
+      throwForeign();
+    }
+  }
+  [[noreturn]] static void throwForeign();
+  Entity resolve(Entity entity) const;
+
+  std::vector<Command> commands_;
+  std::vector<Entity> destroyed_;
+  std::vector<Entity> created_;
+  std::vector<std::pair<ReserveFn, size_t>> reserves_;
+  std::vector<Block> blocks_;
+  size_t block_index_ = 0;
+  size_t block_offset_ = 0;
+  uint32_t pending_count_ = 0;
+  uint32_t tag_;
+};
+
+}  // namespace karma::ecs
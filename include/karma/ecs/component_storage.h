@@ -1,68 +1,330 @@
 #pragma once
 
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <limits>
+#include <memory>
+#include <span>
 #include <utility>
 #include <vector>
 
+#include "karma/core/aligned_allocator.h"
 #include "karma/ecs/entity.h"
+#include "karma/ecs/signal.h"
+#include "karma/ecs/tick.h"
 
 namespace karma::ecs {
 
 template <typename T>
 class ComponentStorage {
  public:
+  using ComponentSignal = Signal<Entity, T&>;
+
   bool has(Entity entity) const {
-    return entity.index < sparse_.size() &&
-           sparse_[entity.index] != kInvalidIndex;
+    const size_t page = entity.index >> kPageShift;
+    return page < pages_.size() && pages_[page] &&
+           pages_[page][entity.index & kPageMask] != kInvalidIndex;
+  }
+
+  // Mutable access stamps the entry's change tick; read through a const
+  // storage (or a View<const T>) to leave it untouched.
+  T& get(Entity entity) {
+    const uint32_t dense_index = denseIndex(entity);
+    changed_[dense_index] = *clock_;
+    return components_[dense_index];
   }
 
-  T& get(Entity entity) { return components_[sparse_[entity.index]]; }
+  const T& get(Entity entity) const { return components_[denseIndex(entity)]; }
 
-  const T& get(Entity entity) const { return components_[sparse_[entity.index]]; }
+  template <typename Func>
+  void patch(Entity entity, Func&& func) {
+    T& component = get(entity);
+    func(component);
+    if (!on_update_.empty()) {
+      on_update_.emit(entity, component);
+    }
+  }
 
   void add(Entity entity, T component) {
     if (has(entity)) {
-      components_[sparse_[entity.index]] = std::move(component);
+      const uint32_t dense_index = denseIndex(entity);
+      components_[dense_index] = std::move(component);
+      changed_[dense_index] = *clock_;
+      if (!on_update_.empty()) {
+        on_update_.emit(entity, components_[dense_index]);
+      }
       return;
     }
-    ensureSparse(entity.index);
+    uint32_t& slot = ensureSparse(entity.index);
     dense_.push_back(entity);
     components_.push_back(std::move(component));
-    sparse_[entity.index] = dense_.size() - 1;
+    added_.push_back(*clock_);
+    changed_.push_back(*clock_);
+    slot = static_cast<uint32_t>(dense_.size() - 1);
+    if (!on_construct_.empty()) {
+      on_construct_.emit(entity, components_.back());
+    }
   }
 
   void remove(Entity entity) {
     if (!has(entity)) {
       return;
     }
-    const size_t dense_index = sparse_[entity.index];
-    const size_t last_index = dense_.size() - 1;
+    if (!on_destroy_.empty()) {
+      on_destroy_.emit(entity, components_[denseIndex(entity)]);
+    }
+    uint32_t& slot = sparseSlot(entity.index);
+    const uint32_t dense_index = slot;
+    const uint32_t last_index = static_cast<uint32_t>(dense_.size() - 1);
     if (dense_index != last_index) {
       const Entity last_entity = dense_[last_index];
       dense_[dense_index] = last_entity;
       components_[dense_index] = std::move(components_[last_index]);
-      sparse_[last_entity.index] = dense_index;
+      added_[dense_index] = added_[last_index];
+      changed_[dense_index] = changed_[last_index];
+      sparseSlot(last_entity.index) = dense_index;
     }
     dense_.pop_back();
     components_.pop_back();
-    sparse_[entity.index] = kInvalidIndex;
+    added_.pop_back();
+    changed_.pop_back();
+    slot = kInvalidIndex;
+  }
+
+  // Removes every listed entity that holds T. Entries are matched on the full
+  // id, so stale handles never hit a recycled index. Small batches swap-remove;
+  // large ones tombstone and compact the dense arrays in one forward pass.
+  void removeBatch(std::span<const Entity> entities) {
+    if (entities.size() * kCompactRatio < dense_.size()) {
+      for (const Entity entity : entities) {
+        if (has(entity) && dense_[denseIndex(entity)] == entity) {
+          remove(entity);
+        }
+      }
+      return;
+    }
+    size_t removed = 0;
+    for (const Entity entity : entities) {
+      if (!has(entity)) {
+        continue;
+      }
+      uint32_t& slot = sparseSlot(entity.index);
+      if (dense_[slot] != entity) {
+        continue;
+      }
+      if (!on_destroy_.empty()) {
+        on_destroy_.emit(entity, components_[slot]);
+      }
+      dense_[slot] = Entity{};
+      slot = kInvalidIndex;
+      ++removed;
+    }
+    if (removed == 0) {
+      return;
+    }
+    size_t out = 0;
+    for (size_t i = 0; i < dense_.size(); ++i) {
+      if (!dense_[i].isValid()) {
+        continue;
+      }
+      if (out != i) {
+        dense_[out] = dense_[i];
+        components_[out] = std::move(components_[i]);
+        added_[out] = added_[i];
+        changed_[out] = changed_[i];
+        sparseSlot(dense_[out].index) = static_cast<uint32_t>(out);
+      }
+      ++out;
+    }
+    dense_.resize(out);
+    components_.erase(components_.begin() + static_cast<std::ptrdiff_t>(out), components_.end());
+    added_.resize(out);
+    changed_.resize(out);
   }
 
+  // Makes room for `additional` more entries, growing geometrically.
+  void reserve(size_t additional) {
+    const size_t needed = dense_.size() + additional;
+    if (needed <= dense_.capacity()) {
+      return;
+    }
+    const size_t capacity = std::max(needed, dense_.capacity() * 2);
+    dense_.reserve(capacity);
+    components_.reserve(capacity);
+    added_.reserve(capacity);
+    changed_.reserve(capacity);
+  }
+
+  void clear() {
+    if (!on_destroy_.empty()) {
+      for (size_t i = 0; i < dense_.size(); ++i) {
+        on_destroy_.emit(dense_[i], components_[i]);
+      }
+    }
+    dense_.clear();
+    components_.clear();
+    added_.clear();
+    changed_.clear();
+    pages_.clear();
+  }
+
+  // Replaces the contents with dense.size() entries, all stamped at the current
+  // tick. fill(T* components, size_t count) writes over default-constructed
+  // components in dense order.
+  template <typename Fill>
+  void restore(std::span<const Entity> dense, Fill&& fill) {
+    clear();
+    dense_.assign(dense.begin(), dense.end());
+    components_.resize(dense.size());
+    fill(components_.data(), dense.size());
+    added_.assign(dense.size(), *clock_);
+    changed_.assign(dense.size(), *clock_);
+    for (size_t i = 0; i < dense_.size(); ++i) {
+      ensureSparse(dense_[i].index) = static_cast<uint32_t>(i);
+    }
+    if (!on_construct_.empty()) {
+      for (size_t i = 0; i < dense_.size(); ++i) {
+        on_construct_.emit(dense_[i], components_[i]);
+      }
+    }
+  }
+
+  // Lifecycle signals, called with the entity and its component. construct
+  // fires after an add, update after add() replaced an existing component or
+  // patch() ran, destroy before the component is removed (including by
+  // removeBatch and clear). Plain get() writes fire nothing; change ticks cover
+  // those. Handlers must not add or remove T on this storage.
+  ComponentSignal& onConstruct() { return on_construct_; }
+  ComponentSignal& onUpdate() { return on_update_; }
+  ComponentSignal& onDestroy() { return on_destroy_; }
+
   const std::vector<Entity>& denseEntities() const { return dense_; }
 
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+  // Dense position of entity; requires has(entity).
+  size_t index(Entity entity) const { return denseIndex(entity); }
+
+  // Dense position of entity, or npos when it has no T. Folds has() and the
+  // index lookup of get() into a single sparse read.
+  size_t find(Entity entity) const {
+    const size_t page = entity.index >> kPageShift;
+    if (page >= pages_.size() || !pages_[page]) {
+      return npos;
+    }
+    const uint32_t dense_index = pages_[page][entity.index & kPageMask];
+    return dense_index == kInvalidIndex ? npos : dense_index;
+  }
+
+  // Component at a dense position; the mutable overload stamps it like get().
+  T& at(size_t index) {
+    changed_[index] = *clock_;
+    return components_[index];
+  }
+
+  const T& at(size_t index) const { return components_[index]; }
+
+  // Raw dense component array, parallel to denseEntities(). Writes through it
+  // are not stamped; pair them with markChanged().
+  T* data() { return components_.data(); }
+  const T* data() const { return components_.data(); }
+
+  void markChanged(size_t first, size_t last) {
+    std::fill(changed_.begin() + static_cast<std::ptrdiff_t>(first),
+              changed_.begin() + static_cast<std::ptrdiff_t>(last), *clock_);
+  }
+
+  // Exchanges two dense positions without touching their change ticks.
+  void swapEntries(size_t a, size_t b) {
+    if (a == b) {
+      return;
+    }
+    using std::swap;
+    swap(dense_[a], dense_[b]);
+    swap(components_[a], components_[b]);
+    swap(added_[a], added_[b]);
+    swap(changed_[a], changed_[b]);
+    sparseSlot(dense_[a].index) = static_cast<uint32_t>(a);
+    sparseSlot(dense_[b].index) = static_cast<uint32_t>(b);
+  }
+
+  size_t size() const { return dense_.size(); }
+
+  Tick addedTick(Entity entity) const { return added_[denseIndex(entity)]; }
+
+  Tick changedTick(Entity entity) const { return changed_[denseIndex(entity)]; }
+
+  // Bytes held by the sparse pages and the page table.
+  size_t sparseBytes() const {
+    size_t page_count = 0;
+    for (const auto& page : pages_) {
+      page_count += page ? 1 : 0;
+    }
+    return page_count * kPageSize * sizeof(uint32_t) +
+           pages_.capacity() * sizeof(std::unique_ptr<uint32_t[]>);
+  }
+
+  // Bytes held by the dense entity, component and tick arrays.
+  size_t denseBytes() const {
+    return dense_.capacity() * sizeof(Entity) + components_.capacity() * sizeof(T) +
+           (added_.capacity() + changed_.capacity()) * sizeof(Tick);
+  }
+
+  // Raises added and changed ticks older than now - kMaxTickAge to that tick.
+  void clampTicks(Tick now) {
+    const Tick oldest = now - kMaxTickAge;
+    for (Tick& tick : added_) {
+      tick = isNewerTick(oldest, tick) ? oldest : tick;
+    }
+    for (Tick& tick : changed_) {
+      tick = isNewerTick(oldest, tick) ? oldest : tick;
+    }
+  }
+
+  // Points the storage at the owning world's tick counter.
+  void setClock(const Tick* clock) { clock_ = clock; }
+
  private:
-  static constexpr size_t kInvalidIndex = std::numeric_limits<size_t>::max();
+  // 4096 entries (16 KB) per page; pages are allocated on first use so the
+  // sparse side scales with the index ranges actually holding T.
+  static constexpr uint32_t kPageShift = 12;
+  static constexpr uint32_t kPageSize = 1u << kPageShift;
+  static constexpr uint32_t kPageMask = kPageSize - 1;
+  static constexpr uint32_t kInvalidIndex = std::numeric_limits<uint32_t>::max();
+  static constexpr Tick kDefaultClock = kInitialTick;
+  // Batches at least 1/kCompactRatio of the storage take the compaction path.
+  static constexpr size_t kCompactRatio = 8;
 
-  void ensureSparse(uint32_t index) {
-    if (index >= sparse_.size()) {
-      sparse_.resize(index + 1, kInvalidIndex);
+  uint32_t denseIndex(Entity entity) const {
+    return pages_[entity.index >> kPageShift][entity.index & kPageMask];
+  }
+
+  uint32_t& sparseSlot(uint32_t index) { return pages_[index >> kPageShift][index & kPageMask]; }
+
+  uint32_t& ensureSparse(uint32_t index) {
+    const size_t page = index >> kPageShift;
+    if (page >= pages_.size()) {
+      pages_.resize(page + 1);
+    }
+    if (!pages_[page]) {
+      pages_[page] = std::make_unique_for_overwrite<uint32_t[]>(kPageSize);
+      std::fill_n(pages_[page].get(), kPageSize, kInvalidIndex);
     }
+    return pages_[page][index & kPageMask];
   }
 
   std::vector<Entity> dense_;
-  std::vector<size_t> sparse_;
-  std::vector<T> components_;
+  std::vector<std::unique_ptr<uint32_t[]>> pages_;
+  // Cache-line aligned so parallel chunks that start on a 64-entry boundary
+  // never write the same line; get() stamps changed_ from those chunks too.
+  std::vector<T, core::AlignedAllocator<T, std::max(alignof(T), core::kCacheLineSize)>> components_;
+  std::vector<Tick, core::AlignedAllocator<Tick, core::kCacheLineSize>> added_;
+  std::vector<Tick, core::AlignedAllocator<Tick, core::kCacheLineSize>> changed_;
+  const Tick* clock_ = &kDefaultClock;
+  ComponentSignal on_construct_;
+  ComponentSignal on_update_;
+  ComponentSignal on_destroy_;
 };
 
 }  // namespace karma::ecs
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 #include "karma/ecs/entity.h"
@@ -20,6 +22,22 @@ class EntityRegistry {
     return Entity{index, 0};
   }
 
+  // Appends count entities to out: recycled indices first, then one contiguous
+  // run of fresh indices.
+  void create(size_t count, std::vector<Entity>& out) {
+    out.reserve(out.size() + count);
+    for (; count > 0 && !free_list_.empty(); --count) {
+      const uint32_t index = free_list_.back();
+      free_list_.pop_back();
+      out.push_back(Entity{index, generations_[index]});
+    }
+    const uint32_t first = static_cast<uint32_t>(generations_.size());
+    generations_.resize(generations_.size() + count, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+      out.push_back(Entity{first + i, 0});
+    }
+  }
+
   void destroy(Entity entity) {
     if (!isAlive(entity)) {
       return;
@@ -28,6 +46,20 @@ class EntityRegistry {
     free_list_.push_back(entity.index);
   }
 
+  const std::vector<uint32_t>& generations() const { return generations_; }
+  const std::vector<uint32_t>& freeList() const { return free_list_; }
+
+  // Replaces the whole registry state, e.g. when loading a snapshot.
+  void restore(std::vector<uint32_t> generations, std::vector<uint32_t> free_list) {
+    generations_ = std::move(generations);
+    free_list_ = std::move(free_list);
+  }
+
+  void clear() {
+    generations_.clear();
+    free_list_.clear();
+  }
+
   bool isAlive(Entity entity) const {
     return entity.index < generations_.size() &&
            generations_[entity.index] == entity.generation;
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+#include "karma/ecs/component_storage.h"
+#include "karma/ecs/entity.h"
+
+namespace karma::ecs {
+
+class IGroup {
+ public:
+  virtual ~IGroup() = default;
+  // Called after a component of an owned type was added to entity.
+  virtual void onAdd(Entity entity) = 0;
+  // Called before a component of an owned type is removed from entity.
+  virtual void onRemove(Entity entity) = 0;
+  // Re-packs from scratch after owned storages were replaced wholesale.
+  virtual void rebuild() = 0;
+};
+
+// Owning group over Ts. Every entity holding all of Ts sits in [0, size()) of
+// each owned storage, at the same position in all of them, so iteration zips the
+// dense arrays with no sparse lookups. A storage can be owned by one group only.
+// Obtain groups through World::group<Ts...>().
+template <typename... Ts>
+class Group final : public IGroup {
+  static_assert(sizeof...(Ts) > 1, "Group requires at least two component types.");
+
+ public:
+  explicit Group(ComponentStorage<Ts>&... storages) : storages_(&storages...) { rebuild(); }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  bool contains(Entity entity) const {
+    const auto& lead = *std::get<0>(storages_);
+    if (!(std::get<ComponentStorage<Ts>*>(storages_)->has(entity) && ...)) {
+      return false;
+    }
+    const size_t index = lead.index(entity);
+    return index < size_ && lead.denseEntities()[index] == entity;
+  }
+
+  const Entity* entities() const { return std::get<0>(storages_)->denseEntities().data(); }
+
+  // Calls func(Entity, Us&...) for every member; Us defaults to Ts and may be a
+  // const-qualified subset. Non-const Us are stamped as changed up front.
+  template <typename... Us, typename Func>
+  void each(Func&& func) const {
+    each<Us...>(0, size_, func);
+  }
+
+  // Visits members at packed positions [first, last).
+  template <typename... Us, typename Func>
+  void each(size_t first, size_t last, Func&& func) const {
+    if constexpr (sizeof...(Us) == 0) {
+      each<Ts...>(first, last, func);
+    } else {
+      (markChanged<Us>(first, last), ...);
+      const Entity* entities = this->entities();
+      auto arrays = std::make_tuple(componentsFor<Us>()...);
+      std::apply(
+          [&](auto*... components) {
+            for (size_t i = first; i < last; ++i) {
+              func(entities[i], components[i]...);
+            }
+          },
+          arrays);
+    }
+  }
+
+  void onAdd(Entity entity) override {
+    if (!(std::get<ComponentStorage<Ts>*>(storages_)->has(entity) && ...)) {
+      return;
+    }
+    if (std::get<0>(storages_)->index(entity) < size_) {
+      return;
+    }
+    (swapInto<Ts>(entity, size_), ...);
+    ++size_;
+  }
+
+  void onRemove(Entity entity) override {
+    if (!contains(entity)) {
+      return;
+    }
+    --size_;
+    (swapInto<Ts>(entity, size_), ...);
+  }
+
+  void rebuild() override {
+    size_ = 0;
+    const auto& lead = *std::get<0>(storages_);
+    for (size_t i = 0; i < lead.size(); ++i) {
+      onAdd(lead.denseEntities()[i]);
+    }
+  }
+
+ private:
+  template <typename U>
+  auto* componentsFor() const {
+    auto* storage = std::get<ComponentStorage<std::remove_const_t<U>>*>(storages_);
+    if constexpr (std::is_const_v<U>) {
+      return static_cast<const ComponentStorage<std::remove_const_t<U>>*>(storage)->data();
+    } else {
+      return storage->data();
+    }
+  }
+
+  template <typename U>
+  void markChanged(size_t first, size_t last) const {
+    if constexpr (!std::is_const_v<U>) {
+      std::get<ComponentStorage<U>*>(storages_)->markChanged(first, last);
+    }
+  }
+
+  template <typename T>
+  void swapInto(Entity entity, size_t position) {
+    auto& storage = *std::get<ComponentStorage<T>*>(storages_);
+    storage.swapEntries(storage.index(entity), position);
+  }
+
+  std::tuple<ComponentStorage<Ts>*...> storages_;
+  size_t size_ = 0;
+};
+
+}  // namespace karma::ecs
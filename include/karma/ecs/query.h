@@ -0,0 +1,237 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "karma/ecs/component_storage.h"
+#include "karma/ecs/entity_registry.h"
+#include "karma/ecs/view.h"
+
+namespace karma::ecs {
+
+// Query clauses. Component types may be const-qualified for read-only access.
+template <typename... Ts>
+struct With {};
+
+template <typename... Ts>
+struct Without {};
+
+template <typename... Ts>
+struct Optional {};
+
+template <typename WithClause, typename WithoutClause, typename OptionalClause>
+class Query;
+
+// Entities that have all of Ws and none of Xs. Each match yields Ws&... plus an
+// Os* per optional type that is null when the entity lacks it. Storages are
+// resolved once when the query is built; iteration drives from the smallest
+// With storage and reads every other storage with one sparse lookup per entity.
+// Obtain queries through World::query<Clauses...>().
+template <typename... Ws, typename... Xs, typename... Os>
+class Query<With<Ws...>, Without<Xs...>, Optional<Os...>> {
+  static_assert(sizeof...(Ws) > 0, "Query requires at least one With component.");
+
+  static constexpr size_t kNotFound = std::numeric_limits<size_t>::max();
+
+  struct Match {
+    std::array<size_t, sizeof...(Ws)> with{};
+    std::array<size_t, sizeof...(Os)> optional{};
+  };
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::tuple<Entity, Ws&..., Os*...>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    iterator() = default;
+
+    value_type operator*() const { return query_->resolve(query_->first_[position_], match_); }
+
+    iterator& operator++() {
+      ++position_;
+      skipMismatches();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const iterator& a, const iterator& b) { return a.position_ == b.position_; }
+    friend bool operator!=(const iterator& a, const iterator& b) { return a.position_ != b.position_; }
+
+   private:
+    friend class Query;
+
+    iterator(const Query* query, size_t position) : query_(query), position_(position) {
+      skipMismatches();
+    }
+
+    void skipMismatches() {
+      while (position_ != query_->sizeHint() && !query_->match(position_, match_)) {
+        ++position_;
+      }
+    }
+
+    const Query* query_ = nullptr;
+    size_t position_ = 0;
+    Match match_{};
+  };
+
+  // Holds the query by value; see View::EachRange.
+  class EachRange {
+   public:
+    iterator begin() const { return iterator(&query_, 0); }
+    iterator end() const { return iterator(&query_, query_.sizeHint()); }
+
+   private:
+    friend class Query;
+
+    explicit EachRange(const Query& query) : query_(query) {}
+
+    Query query_;
+  };
+
+  Query(const EntityRegistry& registry, StorageFor<Ws>&... with,
+        const ComponentStorage<std::remove_const_t<Xs>>&... without, StorageFor<Os>&... optional)
+      : registry_(&registry), with_(&with...), without_(&without...), optional_(&optional...) {
+    size_t index = 0;
+    size_t smallest = std::get<0>(with_)->size();
+    ((with.size() < smallest ? (smallest = with.size(), driver_ = index) : 0, ++index), ...);
+    first_ = driverEntities(std::index_sequence_for<Ws...>{});
+    count_ = smallest;
+  }
+
+  // Upper bound on the number of entities the query yields.
+  size_t sizeHint() const { return count_; }
+
+  bool empty() const { return iterator(this, 0) == iterator(this, sizeHint()); }
+
+  bool contains(Entity entity) const {
+    Match ignored;
+    return registry_->isAlive(entity) &&
+           matchEntity(entity, sizeof...(Ws), ignored, std::index_sequence_for<Ws...>{});
+  }
+
+  // Yields std::tuple<Entity, Ws&..., Os*...> for structured bindings.
+  EachRange each() const { return EachRange(*this); }
+
+  // Calls func(Entity, Ws&..., Os*...) for every match.
+  template <typename Func>
+  void each(Func&& func) const {
+    each(0, sizeHint(), func);
+  }
+
+  // Visits positions [first, last) of the driving storage's dense array.
+  template <typename Func>
+  void each(size_t first, size_t last, Func&& func) const {
+    Match found;
+    for (size_t position = first; position != last; ++position) {
+      if (match(position, found)) {
+        std::apply(func, resolve(first_[position], found));
+      }
+    }
+  }
+
+ private:
+  template <size_t... Is>
+  const Entity* driverEntities(std::index_sequence<Is...>) const {
+    const Entity* entities = nullptr;
+    ((Is == driver_ ? (entities = std::get<Is>(with_)->denseEntities().data(), 0) : 0), ...);
+    return entities;
+  }
+
+  bool match(size_t position, Match& out) const {
+    const Entity entity = first_[position];
+    if (!registry_->isAlive(entity)) {
+      return false;
+    }
+    out.with[driver_] = position;
+    return matchEntity(entity, driver_, out, std::index_sequence_for<Ws...>{});
+  }
+
+  // Fills out with the dense position of every With and Optional type; the
+  // slot at index `known` was already set by the caller.
+  template <size_t... Is>
+  bool matchEntity(Entity entity, size_t known, Match& out, std::index_sequence<Is...>) const {
+    const bool has_all =
+        ((Is == known || (out.with[Is] = std::get<Is>(with_)->find(entity)) != kNotFound) && ...);
+    if (!has_all || (std::get<const ComponentStorage<std::remove_const_t<Xs>>*>(without_)->has(entity) || ...)) {
+      return false;
+    }
+    findOptional(entity, out, std::index_sequence_for<Os...>{});
+    return true;
+  }
+
+  template <size_t... Is>
+  void findOptional([[maybe_unused]] Entity entity, [[maybe_unused]] Match& out,
+                    std::index_sequence<Is...>) const {
+    ((out.optional[Is] = std::get<Is>(optional_)->find(entity)), ...);
+  }
+
+  std::tuple<Entity, Ws&..., Os*...> resolve(Entity entity, const Match& found) const {
+    return resolveImpl(entity, found, std::index_sequence_for<Ws...>{}, std::index_sequence_for<Os...>{});
+  }
+
+  template <size_t... Is, size_t... Js>
+  std::tuple<Entity, Ws&..., Os*...> resolveImpl(Entity entity, const Match& found, std::index_sequence<Is...>,
+                                                 std::index_sequence<Js...>) const {
+    return {entity, std::get<Is>(with_)->at(found.with[Is])...,
+            optionalAt<Js>(found.optional[Js])...};
+  }
+
+  template <size_t I>
+  auto* optionalAt(size_t index) const {
+    auto* storage = std::get<I>(optional_);
+    return index == kNotFound ? nullptr : &storage->at(index);
+  }
+
+  const EntityRegistry* registry_ = nullptr;
+  std::tuple<StorageFor<Ws>*...> with_;
+  std::tuple<const ComponentStorage<std::remove_const_t<Xs>>*...> without_;
+  std::tuple<StorageFor<Os>*...> optional_;
+  size_t driver_ = 0;
+  const Entity* first_ = nullptr;
+  size_t count_ = 0;
+};
+
+namespace detail {
+
+template <typename Built, typename... Clauses>
+struct QueryBuilder;
+
+template <typename Built>
+struct QueryBuilder<Built> {
+  using type = Built;
+};
+
+template <typename... Ws, typename... Xs, typename... Os, typename... Ns, typename... Rest>
+struct QueryBuilder<Query<With<Ws...>, Without<Xs...>, Optional<Os...>>, With<Ns...>, Rest...>
+    : QueryBuilder<Query<With<Ws..., Ns...>, Without<Xs...>, Optional<Os...>>, Rest...> {};
+
+template <typename... Ws, typename... Xs, typename... Os, typename... Ns, typename... Rest>
+struct QueryBuilder<Query<With<Ws...>, Without<Xs...>, Optional<Os...>>, Without<Ns...>, Rest...>
+    : QueryBuilder<Query<With<Ws...>, Without<Xs..., Ns...>, Optional<Os...>>, Rest...> {};
+
+template <typename... Ws, typename... Xs, typename... Os, typename... Ns, typename... Rest>
+struct QueryBuilder<Query<With<Ws...>, Without<Xs...>, Optional<Os...>>, Optional<Ns...>, Rest...>
+    : QueryBuilder<Query<With<Ws...>, Without<Xs...>, Optional<Os..., Ns...>>, Rest...> {};
+
+}  // namespace detail
+
+// Query type for clauses given in any order; repeated clauses are concatenated.
+template <typename... Clauses>
+using QueryFor = typename detail::QueryBuilder<Query<With<>, Without<>, Optional<>>, Clauses...>::type;
+
+}  // namespace karma::ecs
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace karma::ecs {
+
+// Handle returned by Signal::connect. Disconnects on destruction; a connection
+// that outlives its signal is inert.
+class Connection {
+ public:
+  Connection() = default;
+  ~Connection() { disconnect(); }
+
+  Connection(Connection&& other) noexcept
+      : state_(std::move(other.state_)), remove_(other.remove_), id_(other.id_) {
+    other.state_.reset();
+  }
+
+  Connection& operator=(Connection&& other) noexcept {
+    if (this != &other) {
+      disconnect();
+      state_ = std::move(other.state_);
+      remove_ = other.remove_;
+      id_ = other.id_;
+      other.state_.reset();
+    }
+    return *this;
+  }
+
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+
+  bool connected() const { return !state_.expired(); }
+
+  void disconnect() {
+    if (auto state = state_.lock()) {
+      remove_(state.get(), id_);
+    }
+    state_.reset();
+  }
+
+ private:
+  template <typename...>
+  friend class Signal;
+
+  Connection(std::weak_ptr<void> state, void (*remove)(void*, uint64_t), uint64_t id)
+      : state_(std::move(state)), remove_(remove), id_(id) {}
+
+  std::weak_ptr<void> state_;
+  void (*remove_)(void*, uint64_t) = nullptr;
+  uint64_t id_ = 0;
+};
+
+// Handlers run synchronously, in connection order, on the emitting thread.
+// Connecting or disconnecting from inside a handler of the same signal is not
+// supported.
+template <typename... Args>
+class Signal {
+ public:
+  using Handler = std::function<void(Args...)>;
+
+  [[nodiscard]] Connection connect(Handler handler) {
+    const uint64_t id = state_->next_id++;
+    state_->slots.push_back(Slot{id, std::move(handler)});
+    return Connection(state_, &removeSlot, id);
+  }
+
+  bool empty() const { return state_->slots.empty(); }
+
+  void emit(Args... args) const {
+    for (const Slot& slot : state_->slots) {
+      slot.handler(args...);
+    }
+  }
+
+ private:
+  struct Slot {
+    uint64_t id;
+    Handler handler;
+  };
+
+  struct State {
+    std::vector<Slot> slots;
+    uint64_t next_id = 0;
+  };
+
+  static void removeSlot(void* state, uint64_t id) {
+    auto& slots = static_cast<State*>(state)->slots;
+    slots.erase(std::remove_if(slots.begin(), slots.end(), [&](const Slot& slot) { return slot.id == id; }),
+                slots.end());
+  }
+
+  std::shared_ptr<State> state_ = std::make_shared<State>();
+};
+
+}  // namespace karma::ecs
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "karma/ecs/world.h"
+
+namespace karma::ecs {
+
+class SnapshotWriter {
+ public:
+  void writeBytes(const void* data, size_t size);
+  void writeString(std::string_view value);
+  // Pads with zeros to the next multiple of alignment.
+  void align(size_t alignment);
+
+  template <typename T>
+  void write(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "SnapshotWriter::write needs a trivially copyable type.");
+    writeBytes(&value, sizeof(T));
+  }
+
+  // Overwrites a value written earlier at offset.
+  template <typename T>
+  void patch(size_t offset, const T& value) {
+    std::memcpy(bytes_.data() + offset, &value, sizeof(T));
+  }
+
+  size_t size() const { return bytes_.size(); }
+  const std::vector<std::byte>& bytes() const { return bytes_; }
+
+ private:
+  std::vector<std::byte> bytes_;
+};
+
+// Cursor over a snapshot image; throws std::runtime_error on truncated input.
+class SnapshotReader {
+ public:
+  SnapshotReader(const std::byte* data, size_t size) : data_(data), size_(size) {}
+
+  // Returns a pointer into the image and advances past size bytes.
+  const std::byte* readBytes(size_t size);
+  // readBytes for count elements, rejecting counts that cannot fit the image.
+  const std::byte* readArray(size_t count, size_t element_size);
+  std::string readString();
+  void align(size_t alignment);
+  void skip(size_t size) { readBytes(size); }
+
+  template <typename T>
+  T read() {
+    static_assert(std::is_trivially_copyable_v<T>, "SnapshotReader::read needs a trivially copyable type.");
+    T value;
+    std::memcpy(&value, readBytes(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  size_t offset() const { return offset_; }
+
+ private:
+  const std::byte* data_ = nullptr;
+  size_t size_ = 0;
+  size_t offset_ = 0;
+};
+
+// Maps stable names to component types for saveSnapshot/loadSnapshot. Trivially
+// copyable components are written as one raw block per storage and restored with
+// a single memcpy; anything else needs save/load callbacks.
+class SnapshotRegistry {
+ public:
+  template <typename T>
+  using SaveFn = std::function<void(const T&, SnapshotWriter&)>;
+  template <typename T>
+  using LoadFn = std::function<T(SnapshotReader&)>;
+
+  // Every engine component, with serializers for the string-bearing ones.
+  static SnapshotRegistry engineDefaults();
+
+  template <typename T>
+  void add(std::string name) {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "Components that are not trivially copyable need save/load callbacks.");
+    entries_.push_back(Entry{
+        std::move(name), static_cast<uint32_t>(sizeof(T)),
+        [](const World& world, SnapshotWriter& out) {
+          const auto& storage = world.storage<T>();
+          writeDense(storage, out);
+          out.align(kBlockAlignment);
+          out.writeBytes(storage.data(), storage.size() * sizeof(T));
+        },
+        [](SnapshotReader& in, const EntityRegistry& entities) -> Commit {
+          const std::span<const Entity> dense = readDense(in, entities);
+          in.align(kBlockAlignment);
+          const std::byte* components = in.readArray(dense.size(), sizeof(T));
+          return [dense, components](World& world) {
+            world.restoreStorage<T>(dense, [&](T* out, size_t n) {
+              std::memcpy(static_cast<void*>(out), components, n * sizeof(T));
+            });
+          };
+        }});
+  }
+
+  template <typename T>
+  void add(std::string name, SaveFn<T> save, LoadFn<T> load) {
+    entries_.push_back(Entry{
+        std::move(name), 0,
+        [save = std::move(save)](const World& world, SnapshotWriter& out) {
+          const auto& storage = world.storage<T>();
+          writeDense(storage, out);
+          for (size_t i = 0; i < storage.size(); ++i) {
+            save(storage.data()[i], out);
+          }
+        },
+        [load = std::move(load)](SnapshotReader& in, const EntityRegistry& entities) -> Commit {
+          const std::span<const Entity> dense = readDense(in, entities);
+          std::vector<T> values;
+          values.reserve(dense.size());
+          for (size_t i = 0; i < dense.size(); ++i) {
+            values.push_back(load(in));
+          }
+          return [dense, values = std::move(values)](World& world) mutable {
+            world.restoreStorage<T>(dense, [&](T* out, size_t n) {
+              std::move(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(n), out);
+            });
+          };
+        }});
+  }
+
+ private:
+  friend void saveSnapshot(const World&, const SnapshotRegistry&, SnapshotWriter&);
+  friend void loadSnapshot(World&, const SnapshotRegistry&, SnapshotReader&);
+
+  static constexpr size_t kBlockAlignment = 64;
+
+  // Installs one parsed section; may point into the image being loaded.
+  using Commit = std::function<void(World&)>;
+
+  struct Entry {
+    std::string name;
+    // sizeof(T) for raw blocks, 0 for callback-serialized components.
+    uint32_t element_size;
+    std::function<void(const World&, SnapshotWriter&)> save;
+    // Parses and validates a section against the registry being restored
+    // without touching the world.
+    std::function<Commit(SnapshotReader&, const EntityRegistry&)> load;
+  };
+
+  template <typename T>
+  static void writeDense(const ComponentStorage<T>& storage, SnapshotWriter& out) {
+    out.write<uint64_t>(storage.size());
+    out.align(kBlockAlignment);
+    out.writeBytes(storage.denseEntities().data(), storage.size() * sizeof(Entity));
+  }
+
+  static std::span<const Entity> readDense(SnapshotReader& in, const EntityRegistry& entities) {
+    const auto count = static_cast<size_t>(in.read<uint64_t>());
+    in.align(kBlockAlignment);
+    const std::byte* bytes = in.readArray(count, sizeof(Entity));
+    const std::span<const Entity> dense{reinterpret_cast<const Entity*>(bytes), count};
+    validateDense(dense, entities);
+    return dense;
+  }
+
+  // Throws unless every entity is alive in entities and listed once.
+  static void validateDense(std::span<const Entity> dense, const EntityRegistry& entities);
+
+  std::vector<Entry> entries_;
+};
+
+// Whole-world snapshots in sparse-set mode: the entity registry (generations and
+// free list) plus every registered storage. Loading clears the world first and
+// stamps all restored components at the current tick, so change-tracking
+// consumers treat them as new. Sections for unregistered names are skipped.
+// A malformed image throws std::runtime_error and leaves the world untouched.
+void saveSnapshot(const World& world, const SnapshotRegistry& registry, SnapshotWriter& out);
+void loadSnapshot(World& world, const SnapshotRegistry& registry, SnapshotReader& in);
+
+void saveSnapshot(const World& world, const SnapshotRegistry& registry,
+                  const std::filesystem::path& path);
+// Memory-maps path where the platform allows it and restores from the mapping.
+void loadSnapshot(World& world, const SnapshotRegistry& registry, const std::filesystem::path& path);
+
+}  // namespace karma::ecs
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+namespace karma::ecs {
+
+using Tick = uint32_t;
+
+inline constexpr Tick kInitialTick = 1;
+
+// Wrap-safe comparison; valid while the two ticks are less than 2^31 apart.
+constexpr bool isNewerTick(Tick tick, Tick since) {
+  return static_cast<int32_t>(tick - since) > 0;
+}
+
+// Every kTickCheckInterval ticks the World raises stored ticks older than
+// kMaxTickAge to that age, so an untouched component never drifts 2^31 behind
+// the clock and starts comparing newer than every `since`.
+inline constexpr Tick kTickCheckInterval = Tick{1} << 29;
+inline constexpr Tick kMaxTickAge = Tick{1} << 30;
+
+}  // namespace karma::ecs
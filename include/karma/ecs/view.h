@@ -0,0 +1,241 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "karma/ecs/component_storage.h"
+#include "karma/ecs/entity_registry.h"
+#include "karma/ecs/tick.h"
+
+namespace karma::ecs {
+
+template <typename T>
+using StorageFor = std::conditional_t<std::is_const_v<T>,
+                                      const ComponentStorage<std::remove_const_t<T>>,
+                                      ComponentStorage<T>>;
+
+template <typename T, typename... Ts>
+constexpr size_t typeIndexOf() {
+  constexpr bool matches[] = {std::is_same_v<std::remove_const_t<T>, std::remove_const_t<Ts>>...};
+  for (size_t i = 0; i < sizeof...(Ts); ++i) {
+    if (matches[i]) {
+      return i;
+    }
+  }
+  return sizeof...(Ts);
+}
+
+// Non-owning view over every live entity that has all of Ts. Iteration walks the
+// dense array of the smallest participating storage in place; nothing is
+// allocated. Const-qualified types yield const references. Adding or removing
+// components of the viewed types while iterating invalidates the view.
+template <typename... Ts>
+class View {
+  static_assert(sizeof...(Ts) > 0, "View requires at least one component type.");
+
+ public:
+  class iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Entity;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Entity*;
+    using reference = Entity;
+
+    iterator() = default;
+
+    Entity operator*() const { return *it_; }
+
+    iterator& operator++() {
+      ++it_;
+      skipMismatches();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    friend bool operator==(const iterator& a, const iterator& b) { return a.it_ == b.it_; }
+    friend bool operator!=(const iterator& a, const iterator& b) { return a.it_ != b.it_; }
+
+   private:
+    friend class View;
+
+    iterator(const View* view, const Entity* it, const Entity* last)
+        : view_(view), it_(it), last_(last) {
+      skipMismatches();
+    }
+
+    void skipMismatches() {
+      while (it_ != last_ && !view_->contains(*it_)) {
+        ++it_;
+      }
+    }
+
+    const View* view_ = nullptr;
+    const Entity* it_ = nullptr;
+    const Entity* last_ = nullptr;
+  };
+
+  class each_iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::tuple<Entity, Ts&...>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = value_type;
+
+    each_iterator() = default;
+
+    value_type operator*() const {
+      const Entity entity = *it_;
+      return value_type{entity, view_->template get<Ts>(entity)...};
+    }
+
+    each_iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+
+    each_iterator operator++(int) {
+      each_iterator copy = *this;
+      ++it_;
+      return copy;
+    }
+
+    friend bool operator==(const each_iterator& a, const each_iterator& b) {
+      return a.it_ == b.it_;
+    }
+    friend bool operator!=(const each_iterator& a, const each_iterator& b) {
+      return a.it_ != b.it_;
+    }
+
+   private:
+    friend class View;
+
+    each_iterator(const View* view, iterator it) : view_(view), it_(it) {}
+
+    const View* view_ = nullptr;
+    iterator it_{};
+  };
+
+  // Holds the view by value so `for (auto [e, a] : world.view<A>().each())`
+  // stays valid after the temporary view is destroyed.
+  class EachRange {
+   public:
+    each_iterator begin() const { return {&view_, view_.begin()}; }
+    each_iterator end() const { return {&view_, view_.end()}; }
+
+   private:
+    friend class View;
+
+    explicit EachRange(const View& view) : view_(view) {}
+
+    View view_;
+  };
+
+  View(const EntityRegistry& registry, StorageFor<Ts>&... storages)
+      : registry_(&registry), storages_(&storages...) {
+    const auto* smallest = &std::get<0>(storages_)->denseEntities();
+    ((smallest = storages.denseEntities().size() < smallest->size()
+                     ? &storages.denseEntities()
+                     : smallest),
+     ...);
+    first_ = smallest->data();
+    last_ = smallest->data() + smallest->size();
+  }
+
+  iterator begin() const { return iterator(this, first_, last_); }
+  iterator end() const { return iterator(this, last_, last_); }
+
+  // Upper bound on the number of entities the view yields.
+  size_t sizeHint() const { return static_cast<size_t>(last_ - first_); }
+
+  bool empty() const { return begin() == end(); }
+
+  bool contains(Entity entity) const {
+    if (!registry_->isAlive(entity) || !(std::get<StorageFor<Ts>*>(storages_)->has(entity) && ...)) {
+      return false;
+    }
+    return !filtered_ || passesFilters(entity, std::index_sequence_for<Ts...>{});
+  }
+
+  // Returns T as declared in the view, so get<T>() on a View<const T> is const.
+  template <typename T>
+  auto& get(Entity entity) const {
+    constexpr size_t index = typeIndexOf<T, Ts...>();
+    static_assert(index < sizeof...(Ts), "Component type is not part of this view.");
+    return std::get<index>(storages_)->get(entity);
+  }
+
+  // Narrows the view to entities whose T was written or added after `since`.
+  template <typename T>
+  View changed(Tick since) const {
+    constexpr size_t index = typeIndexOf<T, Ts...>();
+    static_assert(index < sizeof...(Ts), "Component type is not part of this view.");
+    View copy = *this;
+    copy.changed_since_[index] = since;
+    copy.filtered_ = true;
+    return copy;
+  }
+
+  template <typename T>
+  View added(Tick since) const {
+    constexpr size_t index = typeIndexOf<T, Ts...>();
+    static_assert(index < sizeof...(Ts), "Component type is not part of this view.");
+    View copy = *this;
+    copy.added_since_[index] = since;
+    copy.filtered_ = true;
+    return copy;
+  }
+
+  // Yields std::tuple<Entity, Ts&...> so loops can use structured bindings.
+  EachRange each() const { return EachRange(*this); }
+
+  template <typename Func>
+  void each(Func&& func) const {
+    each(0, sizeHint(), func);
+  }
+
+  // Visits positions [first, last) of the driving storage's dense array.
+  template <typename Func>
+  void each(size_t first, size_t last, Func&& func) const {
+    for (const Entity* it = first_ + first; it != first_ + last; ++it) {
+      const Entity entity = *it;
+      if (!contains(entity)) {
+        continue;
+      }
+      func(entity, get<Ts>(entity)...);
+    }
+  }
+
+ private:
+  static constexpr Tick kNoFilter = 0;
+
+  template <size_t... Is>
+  bool passesFilters(Entity entity, std::index_sequence<Is...>) const {
+    return ((changed_since_[Is] == kNoFilter ||
+             isNewerTick(std::get<Is>(storages_)->changedTick(entity), changed_since_[Is])) &&
+            ...) &&
+           ((added_since_[Is] == kNoFilter ||
+             isNewerTick(std::get<Is>(storages_)->addedTick(entity), added_since_[Is])) &&
+            ...);
+  }
+
+  const EntityRegistry* registry_ = nullptr;
+  std::tuple<StorageFor<Ts>*...> storages_;
+  std::array<Tick, sizeof...(Ts)> changed_since_{};
+  std::array<Tick, sizeof...(Ts)> added_since_{};
+  bool filtered_ = false;
+  const Entity* first_ = nullptr;
+  const Entity* last_ = nullptr;
+};
+
+}  // namespace karma::ecs
@@ -1,15 +1,26 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
-#include <tuple>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "karma/core/frame_arena.h"
 #include "karma/core/type_id.h"
+#include "karma/ecs/archetype_storage.h"
+#include "karma/ecs/command_buffer.h"
 #include "karma/ecs/component_storage.h"
 #include "karma/ecs/entity_registry.h"
+#include "karma/ecs/group.h"
+#include "karma/ecs/query.h"
+#include "karma/ecs/view.h"
+#include "karma/tasks/scheduler.h"
 
 #include "karma/components/rigidbody.h"
 #include "karma/components/transform.h"
@@ -18,87 +29,456 @@ namespace karma::ecs {
 
 class World {
  public:
+  explicit World(StorageMode mode = StorageMode::SparseSet) {
+    if (mode == StorageMode::Archetype) {
+      archetypes_ = std::make_unique<ArchetypeStorage>();
+    } else {
+      connectPhysicsLinks();
+    }
+  }
+
+  World(const World&) = delete;
+  World& operator=(const World&) = delete;
+
+  StorageMode storageMode() const {
+    return archetypes_ ? StorageMode::Archetype : StorageMode::SparseSet;
+  }
+
+  // Component writes are stamped with the current tick. A system consuming
+  // View::changed/added records currentTick() after its run and then calls
+  // advanceTick(), so later writes compare newer than what it has seen.
+  Tick currentTick() const { return tick_; }
+
+  void advanceTick() {
+    if (++tick_ % kTickCheckInterval == 0) {
+      for (const auto& storage : storages_) {
+        storage->clampTicks(tick_);
+      }
+    }
+  }
+
   Entity createEntity() { return registry_.create(); }
 
-  void destroyEntity(Entity entity) { registry_.destroy(entity); }
+  // Appends count new entities to out.
+  void createEntities(size_t count, std::vector<Entity>& out) { registry_.create(count, out); }
+
+  // Removes every component of entity before retiring its index, so recycled
+  // indices start empty and storages hold no dead entries.
+  void destroyEntity(Entity entity) {
+    if (!registry_.isAlive(entity)) {
+      return;
+    }
+    if (archetypes_) {
+      archetypes_->destroy(entity);
+    } else {
+      for (auto& owning : groups_) {
+        owning->onRemove(entity);
+      }
+      for (auto& storage : storages_) {
+        storage->remove(entity);
+      }
+    }
+    registry_.destroy(entity);
+  }
+
+  // Batch form of destroyEntity. Sparse-set worlds sweep one storage at a time
+  // over the whole batch instead of visiting every storage per entity. Dead and
+  // duplicate entries are ignored.
+  void destroyEntities(std::span<const Entity> entities) {
+    if (archetypes_) {
+      for (const Entity entity : entities) {
+        if (registry_.isAlive(entity)) {
+          archetypes_->destroy(entity);
+        }
+      }
+    } else {
+      for (auto& owning : groups_) {
+        for (const Entity entity : entities) {
+          owning->onRemove(entity);
+        }
+      }
+      for (auto& storage : storages_) {
+        storage->removeBatch(entities);
+      }
+    }
+    for (const Entity entity : entities) {
+      registry_.destroy(entity);
+    }
+  }
 
   bool isAlive(Entity entity) const { return registry_.isAlive(entity); }
 
+  const EntityRegistry& registry() const { return registry_; }
+
+  // Destroys every entity and component. Storages, groups and the tick survive.
+  void clear() {
+    registry_.clear();
+    if (archetypes_) {
+      archetypes_->clear();
+    }
+    for (auto& storage : storages_) {
+      storage->clear();
+    }
+    for (auto& owning : groups_) {
+      owning->rebuild();
+    }
+  }
+
+  // Clears the world and installs registry, for snapshot loading.
+  void restoreRegistry(EntityRegistry registry) {
+    clear();
+    registry_ = std::move(registry);
+  }
+
+  // Replaces T's storage contents in one pass; see ComponentStorage::restore.
+  // Sparse-set mode only.
+  template <typename T, typename Fill>
+  void restoreStorage(std::span<const Entity> dense, Fill&& fill) {
+    requireSparseSet("restoreStorage");
+    auto& storage = getStorage<T>();
+    storage.data.restore(dense, std::forward<Fill>(fill));
+    if (storage.group) {
+      storage.group->rebuild();
+    }
+  }
+
   template <typename T>
   void add(Entity entity, T component) {
     if constexpr (HasValidate<T>::value) {
       T::Validate(*this, entity);
     }
-    if constexpr (std::is_same_v<T, components::TransformComponent>) {
-      if (has<components::RigidbodyComponent>(entity)) {
-        const auto& body = get<components::RigidbodyComponent>(entity);
-        component.setHasPhysics(true);
-        component.setPhysicsWriteWarning(!body.is_kinematic);
+    if (archetypes_) {
+      archetypes_->add(entity, std::move(component));
+      linkArchetypePhysics<T>(entity);
+    } else {
+      auto& storage = getStorage<T>();
+      storage.data.add(entity, std::move(component));
+      if (storage.group) {
+        storage.group->onAdd(entity);
       }
     }
-    getStorage<T>().data.add(entity, std::move(component));
-    if constexpr (std::is_same_v<T, components::RigidbodyComponent>) {
-      if (has<components::TransformComponent>(entity)) {
-        auto& transform = get<components::TransformComponent>(entity);
-        transform.setHasPhysics(true);
-        transform.setPhysicsWriteWarning(!component.is_kinematic);
-      }
+  }
+
+  // Adds components[i] to entities[i]. The storage is resolved and reserved
+  // once for the whole batch.
+  template <typename T>
+  void addBatch(std::span<const Entity> entities, std::span<const T> components) {
+    if (entities.size() != components.size()) {
+      throw std::invalid_argument("World::addBatch: entity and component counts differ.");
     }
+    insertBatch<T>(entities, [&](size_t i) { return components[i]; });
+  }
+
+  // Adds T(args...) to every entity in entities.
+  template <typename T, typename... Args>
+  void emplaceBatch(std::span<const Entity> entities, const Args&... args) {
+    insertBatch<T>(entities, [&](size_t) { return T(args...); });
   }
 
   template <typename T>
   bool has(Entity entity) const {
+    if (archetypes_) {
+      return archetypes_->has<T>(entity);
+    }
     return getStorage<T>().data.has(entity);
   }
 
   template <typename T>
   T& get(Entity entity) {
+    if (archetypes_) {
+      return archetypes_->get<T>(entity);
+    }
     return getStorage<T>().data.get(entity);
   }
 
   template <typename T>
   const T& get(Entity entity) const {
+    if (archetypes_) {
+      return archetypes_->get<T>(entity);
+    }
     return getStorage<T>().data.get(entity);
   }
 
+  // Applies func to the component, stamps it as changed and fires T's update
+  // signal.
+  template <typename T, typename Func>
+  void patch(Entity entity, Func&& func) {
+    if (archetypes_) {
+      func(get<T>(entity));
+    } else {
+      getStorage<T>().data.patch(entity, std::forward<Func>(func));
+    }
+  }
+
   template <typename T>
   void remove(Entity entity) {
-    getStorage<T>().data.remove(entity);
-    if constexpr (std::is_same_v<T, components::RigidbodyComponent>) {
-      if (has<components::TransformComponent>(entity)) {
-        auto& transform = get<components::TransformComponent>(entity);
-        transform.setHasPhysics(false);
-        transform.setPhysicsWriteWarning(true);
+    if (archetypes_) {
+      archetypes_->remove<T>(entity);
+      if constexpr (std::is_same_v<T, components::RigidbodyComponent>) {
+        if (has<components::TransformComponent>(entity)) {
+          unlinkPhysics(get<components::TransformComponent>(entity));
+        }
+      }
+    } else {
+      auto& storage = getStorage<T>();
+      if (storage.group) {
+        storage.group->onRemove(entity);
       }
+      storage.data.remove(entity);
     }
   }
 
+  // Pre-sizes T's storage for `additional` more components. No-op in archetype mode.
+  template <typename T>
+  void reserve(size_t additional) {
+    if (!archetypes_) {
+      getStorage<T>().data.reserve(additional);
+    }
+  }
+
+  // Sparse-set mode only; archetype worlds have no per-type storage.
   template <typename T>
   ComponentStorage<T>& storage() {
+    requireSparseSet("storage");
     return getStorage<T>().data;
   }
 
   template <typename T>
   const ComponentStorage<T>& storage() const {
+    requireSparseSet("storage");
     return getStorage<T>().data;
   }
 
+  // T's lifecycle signals; see ComponentStorage::onConstruct. Sparse-set mode
+  // only. Handlers may touch other storages but must not add or remove T.
+  template <typename T>
+  typename ComponentStorage<T>::ComponentSignal& onConstruct() {
+    return storage<T>().onConstruct();
+  }
+
+  template <typename T>
+  typename ComponentStorage<T>::ComponentSignal& onUpdate() {
+    return storage<T>().onUpdate();
+  }
+
+  template <typename T>
+  typename ComponentStorage<T>::ComponentSignal& onDestroy() {
+    return storage<T>().onDestroy();
+  }
+
+  // Sparse-set mode only; use each() for code that must run in either mode.
   template <typename... Ts>
-  std::vector<Entity> view() const {
-    std::vector<Entity> entities;
-    const auto& base = storage<std::tuple_element_t<0, std::tuple<Ts...>>>();
-    for (const Entity entity : base.denseEntities()) {
-      if (!isAlive(entity)) {
-        continue;
-      }
-      if ((has<Ts>(entity) && ...)) {
-        entities.push_back(entity);
+  View<Ts...> view() {
+    return View<Ts...>(registry_, storage<std::remove_const_t<Ts>>()...);
+  }
+
+  template <typename... Ts>
+  View<const Ts...> view() const {
+    return View<const Ts...>(registry_, storage<std::remove_const_t<Ts>>()...);
+  }
+
+  // Sparse-set mode only. Clauses are With<...>, Without<...> and Optional<...>
+  // in any order, e.g. query<With<const A>, Without<B>, Optional<const C>>().
+  template <typename... Clauses>
+  QueryFor<Clauses...> query() {
+    return makeQuery(std::type_identity<QueryFor<Clauses...>>{});
+  }
+
+  // Returns the owning group over Ts, creating and packing it on first use.
+  // Throws std::logic_error if one of Ts is already owned by a different group.
+  // Sparse-set mode only.
+  template <typename... Ts>
+  Group<Ts...>& group() {
+    requireSparseSet("group");
+    const core::TypeId id = core::typeId<Group<Ts...>>();
+    for (const auto& [group_id, existing] : groups_by_type_) {
+      if (group_id == id) {
+        return *static_cast<Group<Ts...>*>(existing);
       }
     }
-    return entities;
+    if (((getStorage<Ts>().group != nullptr) || ...)) {
+      throw std::logic_error("World::group: a component type is already owned by another group.");
+    }
+    auto created = std::make_unique<Group<Ts...>>(getStorage<Ts>().data...);
+    auto* group_ptr = created.get();
+    ((getStorage<Ts>().group = group_ptr), ...);
+    groups_.push_back(std::move(created));
+    groups_by_type_.emplace_back(id, group_ptr);
+    return *group_ptr;
+  }
+
+  // Calls func(Entity, Ts&...) for every live entity that has all of Ts.
+  template <typename... Ts, typename Func>
+  void each(Func&& func) {
+    if (archetypes_) {
+      archetypes_->each<Ts...>(std::forward<Func>(func));
+    } else {
+      view<Ts...>().each(std::forward<Func>(func));
+    }
+  }
+
+  // Runs func(Entity, Ts&...) on the engine worker pool. Chunk boundaries depend
+  // only on the query size and min_chunk, and fall on 64-entry multiples of the
+  // driving storage so chunks never write the same cache line of it. func may
+  // read and write components but must not add/remove components or entities.
+  template <typename... Ts, typename Func>
+  void parallelEach(Func&& func, size_t min_chunk = kParallelMinChunk) {
+    if (archetypes_) {
+      core::FrameVector<ArchetypeStorage::ChunkRef> chunks;
+      chunks.reserve(archetypes_->chunkCount());
+      archetypes_->matchChunks<Ts...>(chunks);
+      tasks::scheduler().parallelFor(chunks.size(), 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t i = begin; i < end; ++i) {
+          archetypes_->eachInChunk<Ts...>(chunks[i], func);
+        }
+      });
+      return;
+    }
+    const auto query = view<Ts...>();
+    const size_t count = query.sizeHint();
+    tasks::scheduler().parallelFor(count, parallelChunkSize(count, min_chunk),
+                                   [&](size_t begin, size_t end, size_t) {
+                                     query.each(begin, end, func);
+                                   });
+  }
+
+  // parallelEach over an owned group's packed range; Us selects and
+  // const-qualifies the visited components as in Group::each.
+  template <typename... Us, typename... Owned, typename Func>
+  void parallelEach(Group<Owned...>& group, Func&& func, size_t min_chunk = kParallelMinChunk) {
+    const size_t count = group.size();
+    tasks::scheduler().parallelFor(count, parallelChunkSize(count, min_chunk),
+                                   [&](size_t begin, size_t end, size_t) {
+                                     group.template each<Us...>(begin, end, func);
+                                   });
+  }
+
+  // parallelEach whose func(CommandBuffer&, Entity, Ts&...) may record structural
+  // changes. Each chunk records into its own buffer; once every chunk has run,
+  // the buffers play back in chunk order, so the outcome does not depend on
+  // which worker ran which chunk.
+  template <typename... Ts, typename Func>
+  void parallelEachDeferred(Func&& func, size_t min_chunk = kParallelMinChunk) {
+    if (archetypes_) {
+      core::FrameVector<ArchetypeStorage::ChunkRef> chunks;
+      chunks.reserve(archetypes_->chunkCount());
+      archetypes_->matchChunks<Ts...>(chunks);
+      prepareDeferred(chunks.size());
+      tasks::scheduler().parallelFor(chunks.size(), 1, [&](size_t begin, size_t end, size_t chunk_index) {
+        CommandBuffer& commands = deferred_[chunk_index];
+        for (size_t i = begin; i < end; ++i) {
+          archetypes_->eachInChunk<Ts...>(chunks[i], [&](Entity entity, Ts&... components) {
+            func(commands, entity, components...);
+          });
+        }
+      });
+    } else {
+      const auto query = view<Ts...>();
+      const size_t count = query.sizeHint();
+      const size_t chunk_size = parallelChunkSize(count, min_chunk);
+      prepareDeferred((count + chunk_size - 1) / chunk_size);
+      tasks::scheduler().parallelFor(count, chunk_size, [&](size_t begin, size_t end, size_t chunk_index) {
+        CommandBuffer& commands = deferred_[chunk_index];
+        query.each(begin, end, [&](Entity entity, Ts&... components) {
+          func(commands, entity, components...);
+        });
+      });
+    }
+    for (CommandBuffer& commands : deferred_) {
+      commands.playback(*this);
+    }
   }
 
  private:
+  // Upper bound on core::typeId values, which are shared by every type that
+  // asks for one; 1024 slots cost 8 KB per World.
+  static constexpr core::TypeId kMaxStorageTypes = 1024;
+  static constexpr size_t kParallelMinChunk = 256;
+  static constexpr size_t kParallelTargetChunks = 64;
+  static constexpr size_t kParallelChunkAlign = 64;
+
+  static size_t parallelChunkSize(size_t count, size_t min_chunk) {
+    const size_t even = (count + kParallelTargetChunks - 1) / kParallelTargetChunks;
+    const size_t size = std::max({even, min_chunk, size_t{1}});
+    return (size + kParallelChunkAlign - 1) / kParallelChunkAlign * kParallelChunkAlign;
+  }
+
+  void prepareDeferred(size_t chunk_count) {
+    if (deferred_.size() < chunk_count) {
+      deferred_.resize(chunk_count);
+    }
+  }
+
+  static void linkPhysics(components::TransformComponent& transform,
+                          const components::RigidbodyComponent& body) {
+    transform.setHasPhysics(true);
+    transform.setPhysicsWriteWarning(!body.is_kinematic);
+  }
+
+  static void unlinkPhysics(components::TransformComponent& transform) {
+    transform.setHasPhysics(false);
+    transform.setPhysicsWriteWarning(true);
+  }
+
+  // Keeps TransformComponent's physics flags in step with a RigidbodyComponent
+  // on the same entity, whichever of the two arrives, changes or leaves first.
+  void connectPhysicsLinks() {
+    auto& transforms = getStorage<components::TransformComponent>().data;
+    auto& bodies = getStorage<components::RigidbodyComponent>().data;
+    const auto link_transform = [&bodies](Entity entity, components::TransformComponent& transform) {
+      if (bodies.has(entity)) {
+        linkPhysics(transform, std::as_const(bodies).get(entity));
+      }
+    };
+    const auto link_body = [&transforms](Entity entity, components::RigidbodyComponent& body) {
+      if (transforms.has(entity)) {
+        linkPhysics(transforms.get(entity), body);
+      }
+    };
+    physics_links_.push_back(transforms.onConstruct().connect(link_transform));
+    physics_links_.push_back(transforms.onUpdate().connect(link_transform));
+    physics_links_.push_back(bodies.onConstruct().connect(link_body));
+    physics_links_.push_back(bodies.onUpdate().connect(link_body));
+    physics_links_.push_back(bodies.onDestroy().connect([&transforms](Entity entity, components::RigidbodyComponent&) {
+      if (transforms.has(entity)) {
+        unlinkPhysics(transforms.get(entity));
+      }
+    }));
+  }
+
+  // Archetype worlds have no storage signals, so the link is made inline.
+  template <typename T>
+  void linkArchetypePhysics(Entity entity) {
+    if constexpr (std::is_same_v<T, components::TransformComponent> ||
+                  std::is_same_v<T, components::RigidbodyComponent>) {
+      if (has<components::TransformComponent>(entity) && has<components::RigidbodyComponent>(entity)) {
+        linkPhysics(get<components::TransformComponent>(entity),
+                    get<components::RigidbodyComponent>(entity));
+      }
+    }
+  }
+
+  template <typename T, typename Make>
+  void insertBatch(std::span<const Entity> entities, Make&& make) {
+    if (archetypes_) {
+      for (size_t i = 0; i < entities.size(); ++i) {
+        add(entities[i], make(i));
+      }
+      return;
+    }
+    auto& storage = getStorage<T>();
+    storage.data.reserve(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i) {
+      if constexpr (HasValidate<T>::value) {
+        T::Validate(*this, entities[i]);
+      }
+      storage.data.add(entities[i], make(i));
+      if (storage.group) {
+        storage.group->onAdd(entities[i]);
+      }
+    }
+  }
+
   template <typename T, typename = void>
   struct HasValidate : std::false_type {};
 
@@ -109,28 +489,86 @@ class World {
 
   struct IStorage {
     virtual ~IStorage() = default;
+    virtual void remove(Entity entity) = 0;
+    virtual void removeBatch(std::span<const Entity> entities) = 0;
+    virtual void clear() = 0;
+    virtual void clampTicks(Tick now) = 0;
   };
 
   template <typename T>
   struct Storage : IStorage {
+    void remove(Entity entity) override { data.remove(entity); }
+
+    void removeBatch(std::span<const Entity> entities) override {
+      if (data.size() != 0) {
+        data.removeBatch(entities);
+      }
+    }
+
+    void clear() override { data.clear(); }
+
+    void clampTicks(Tick now) override { data.clampTicks(now); }
+
     ComponentStorage<T> data;
+    IGroup* group = nullptr;
   };
 
+  template <typename... Ws, typename... Xs, typename... Os>
+  Query<With<Ws...>, Without<Xs...>, Optional<Os...>> makeQuery(
+      std::type_identity<Query<With<Ws...>, Without<Xs...>, Optional<Os...>>>) {
+    return Query<With<Ws...>, Without<Xs...>, Optional<Os...>>(
+        registry_, storage<std::remove_const_t<Ws>>()..., storage<std::remove_const_t<Xs>>()...,
+        storage<std::remove_const_t<Os>>()...);
+  }
+
+  void requireSparseSet(const char* what) const {
+    if (archetypes_) {
+      throw std::logic_error(std::string("World::") + what +
+                             " is unavailable in StorageMode::Archetype.");
+    }
+  }
+
+  // One acquire load on the hot path. A missing storage is created under
+  // storage_mutex_, so first use of a type is safe from worker threads.
   template <typename T>
   Storage<T>& getStorage() const {
     const core::TypeId id = core::typeId<T>();
-    auto it = storages_.find(id);
-    if (it == storages_.end()) {
-      auto storage = std::make_unique<Storage<T>>();
-      auto* storage_ptr = storage.get();
-      storages_[id] = std::move(storage);
-      return *storage_ptr;
+    if (id < kMaxStorageTypes) {
+      if (IStorage* storage = storage_table_[id].load(std::memory_order_acquire)) {
+        return *static_cast<Storage<T>*>(storage);
+      }
+    }
+    return registerStorage<T>(id);
+  }
+
+  template <typename T>
+  Storage<T>& registerStorage(core::TypeId id) const {
+    if (id >= kMaxStorageTypes) {
+      throw std::length_error("World: component type id exceeds the storage table size.");
+    }
+    std::lock_guard<std::mutex> lock(storage_mutex_);
+    if (IStorage* storage = storage_table_[id].load(std::memory_order_acquire)) {
+      return *static_cast<Storage<T>*>(storage);
     }
-    return *static_cast<Storage<T>*>(it->second.get());
+    auto storage = std::make_unique<Storage<T>>();
+    storage->data.setClock(&tick_);
+    auto* storage_ptr = storage.get();
+    storages_.push_back(std::move(storage));
+    storage_table_[id].store(storage_ptr, std::memory_order_release);
+    return *storage_ptr;
   }
 
   EntityRegistry registry_;
-  mutable std::unordered_map<core::TypeId, std::unique_ptr<IStorage>> storages_;
+  Tick tick_ = kInitialTick;
+  std::unique_ptr<ArchetypeStorage> archetypes_;
+  mutable std::vector<std::unique_ptr<IStorage>> storages_;
+  mutable std::unique_ptr<std::atomic<IStorage*>[]> storage_table_{
+      new std::atomic<IStorage*>[kMaxStorageTypes]{}};
+  mutable std::mutex storage_mutex_;
+  std::vector<std::unique_ptr<IGroup>> groups_;
+  std::vector<std::pair<core::TypeId, IGroup*>> groups_by_type_;
+  std::vector<CommandBuffer> deferred_;
+  std::vector<Connection> physics_links_;
 };
 
 }  // namespace karma::ecs
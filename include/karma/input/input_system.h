@@ -7,10 +7,6 @@
 
 #include "karma/platform/events.h"
 
-namespace karma::platform {
-class Window;
-}
-
 namespace karma::input {
 
 enum class Trigger {
@@ -28,8 +24,6 @@ struct Binding {
 
 class InputSystem {
  public:
-  void setWindow(const platform::Window* window) { window_ = window; }
-
   void bindKey(const std::string& action, platform::Key key, Trigger trigger = Trigger::Down);
   void bindMouse(const std::string& action, platform::MouseButton button,
                  Trigger trigger = Trigger::Down);
@@ -47,11 +41,13 @@ class InputSystem {
  private:
   bool matchesModifiers(const platform::Modifiers& event_mods,
                         const platform::Modifiers& required_mods) const;
+  void trackHeld(const platform::Event& event);
 
   std::unordered_map<std::string, std::vector<Binding>> bindings_;
   std::unordered_set<std::string> pressed_this_frame_;
   std::unordered_set<std::string> down_this_frame_;
-  const platform::Window* window_ = nullptr;
+  std::unordered_set<platform::Key> held_keys_;
+  std::unordered_set<platform::MouseButton> held_buttons_;
   float mouse_delta_x_ = 0.0f;
   float mouse_delta_y_ = 0.0f;
   bool has_mouse_pos_ = false;
@@ -15,8 +15,10 @@
 #include "karma/components/tag.h"
 #include "karma/components/transform.h"
 #include "karma/components/visibility.h"
+#include "karma/components/world_matrix.h"
 #include "karma/ecs/world.h"
 #include "karma/input/input_system.h"
+#include "karma/math/mat4.h"
 #include "karma/math/quat.h"
 #include "karma/math/vec3.h"
 #include "karma/network/transport.h"
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cmath>
+
+#include "karma/math/types.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define KARMA_MATH_SSE 1
+#include <xmmintrin.h>
+#endif
+
+namespace karma::math {
+
+// Column-major 4x4 matrix with the same layout as glm::mat4: m[column * 4 + row].
+struct alignas(16) Mat4 {
+  float m[16] = {1.0f, 0.0f, 0.0f, 0.0f,
+                 0.0f, 1.0f, 0.0f, 0.0f,
+                 0.0f, 0.0f, 1.0f, 0.0f,
+                 0.0f, 0.0f, 0.0f, 1.0f};
+
+  const float* column(int index) const { return m + index * 4; }
+  float* column(int index) { return m + index * 4; }
+};
+
+// translate * rotate * scale, as glm::translate(...) * glm::mat4_cast(...) * glm::scale(...).
+inline Mat4 composeTRS(const Vec3& position, const Quat& rotation, const Vec3& scale) {
+  const float x2 = rotation.x + rotation.x;
+  const float y2 = rotation.y + rotation.y;
+  const float z2 = rotation.z + rotation.z;
+  const float xx = rotation.x * x2;
+  const float yy = rotation.y * y2;
+  const float zz = rotation.z * z2;
+  const float xy = rotation.x * y2;
+  const float xz = rotation.x * z2;
+  const float yz = rotation.y * z2;
+  const float wx = rotation.w * x2;
+  const float wy = rotation.w * y2;
+  const float wz = rotation.w * z2;
+
+  Mat4 out;
+#if defined(KARMA_MATH_SSE)
+  // _mm_set_ps takes lanes high to low.
+  _mm_store_ps(out.column(0),
+               _mm_mul_ps(_mm_set_ps(0.0f, xz - wy, xy + wz, 1.0f - (yy + zz)), _mm_set1_ps(scale.x)));
+  _mm_store_ps(out.column(1),
+               _mm_mul_ps(_mm_set_ps(0.0f, yz + wx, 1.0f - (xx + zz), xy - wz), _mm_set1_ps(scale.y)));
+  _mm_store_ps(out.column(2),
+               _mm_mul_ps(_mm_set_ps(0.0f, 1.0f - (xx + yy), yz - wx, xz + wy), _mm_set1_ps(scale.z)));
+  _mm_store_ps(out.column(3), _mm_set_ps(1.0f, position.z, position.y, position.x));
+#else
+  out.m[0] = (1.0f - (yy + zz)) * scale.x;
+  out.m[1] = (xy + wz) * scale.x;
+  out.m[2] = (xz - wy) * scale.x;
+  out.m[3] = 0.0f;
+  out.m[4] = (xy - wz) * scale.y;
+  out.m[5] = (1.0f - (xx + zz)) * scale.y;
+  out.m[6] = (yz + wx) * scale.y;
+  out.m[7] = 0.0f;
+  out.m[8] = (xz + wy) * scale.z;
+  out.m[9] = (yz - wx) * scale.z;
+  out.m[10] = (1.0f - (xx + yy)) * scale.z;
+  out.m[11] = 0.0f;
+  out.m[12] = position.x;
+  out.m[13] = position.y;
+  out.m[14] = position.z;
+  out.m[15] = 1.0f;
+#endif
+  return out;
+}
+
+// a * b: b's transform applied first.
+inline Mat4 mul(const Mat4& a, const Mat4& b) {
+  Mat4 out;
+#if defined(KARMA_MATH_SSE)
+  const __m128 a0 = _mm_load_ps(a.column(0));
+  const __m128 a1 = _mm_load_ps(a.column(1));
+  const __m128 a2 = _mm_load_ps(a.column(2));
+  const __m128 a3 = _mm_load_ps(a.column(3));
+  for (int c = 0; c < 4; ++c) {
+    const float* col = b.column(c);
+    __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(col[0]));
+    sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(col[1])));
+    sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(col[2])));
+    sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(col[3])));
+    _mm_store_ps(out.column(c), sum);
+  }
+#else
+  for (int c = 0; c < 4; ++c) {
+    for (int r = 0; r < 4; ++r) {
+      out.m[c * 4 + r] = a.m[r] * b.m[c * 4] + a.m[4 + r] * b.m[c * 4 + 1] +
+                         a.m[8 + r] * b.m[c * 4 + 2] + a.m[12 + r] * b.m[c * 4 + 3];
+    }
+  }
+#endif
+  return out;
+}
+
+inline Vec3 translation(const Mat4& matrix) {
+  return {matrix.m[12], matrix.m[13], matrix.m[14]};
+}
+
+// Length of each basis column, i.e. the scale of an affine TRS matrix.
+inline Vec3 basisScale(const Mat4& matrix) {
+  const auto len = [&](int c) {
+    const float* col = matrix.column(c);
+    return std::sqrt(col[0] * col[0] + col[1] * col[1] + col[2] * col[2]);
+  };
+  return {len(0), len(1), len(2)};
+}
+
+// Rotation of an affine TRS matrix without shear. Zero-scale axes yield the
+// identity.
+inline Quat rotationOf(const Mat4& matrix) {
+  const Vec3 scale = basisScale(matrix);
+  if (scale.x <= 0.0f || scale.y <= 0.0f || scale.z <= 0.0f) {
+    return {};
+  }
+  const float* c0 = matrix.column(0);
+  const float* c1 = matrix.column(1);
+  const float* c2 = matrix.column(2);
+  const float r00 = c0[0] / scale.x, r10 = c0[1] / scale.x, r20 = c0[2] / scale.x;
+  const float r01 = c1[0] / scale.y, r11 = c1[1] / scale.y, r21 = c1[2] / scale.y;
+  const float r02 = c2[0] / scale.z, r12 = c2[1] / scale.z, r22 = c2[2] / scale.z;
+  const float trace = r00 + r11 + r22;
+  Quat q;
+  if (trace > 0.0f) {
+    const float s = std::sqrt(trace + 1.0f) * 2.0f;
+    q = {(r21 - r12) / s, (r02 - r20) / s, (r10 - r01) / s, 0.25f * s};
+  } else if (r00 > r11 && r00 > r22) {
+    const float s = std::sqrt(1.0f + r00 - r11 - r22) * 2.0f;
+    q = {0.25f * s, (r01 + r10) / s, (r02 + r20) / s, (r21 - r12) / s};
+  } else if (r11 > r22) {
+    const float s = std::sqrt(1.0f + r11 - r00 - r22) * 2.0f;
+    q = {(r01 + r10) / s, 0.25f * s, (r12 + r21) / s, (r02 - r20) / s};
+  } else {
+    const float s = std::sqrt(1.0f + r22 - r00 - r11) * 2.0f;
+    q = {(r02 + r20) / s, (r12 + r21) / s, 0.25f * s, (r10 - r01) / s};
+  }
+  return q;
+}
+
+}  // namespace karma::math
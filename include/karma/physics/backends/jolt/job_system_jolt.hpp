@@ -0,0 +1,40 @@
+#pragma once
+
+#include "karma/tasks/scheduler.h"
+#include <atomic>
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/FixedSizeFreeList.h>
+#include <Jolt/Core/JobSystemWithBarrier.h>
+
+namespace karma::physics_backend {
+
+// Runs Jolt jobs on the engine-wide task scheduler instead of a private
+// JobSystemThreadPool, so physics shares worker threads with the rest of the
+// engine.
+class JobSystemJolt final : public JPH::JobSystemWithBarrier {
+public:
+    JobSystemJolt(tasks::Scheduler& scheduler, JPH::uint maxJobs, JPH::uint maxBarriers);
+    ~JobSystemJolt() override;
+
+    int GetMaxConcurrency() const override;
+    JobHandle CreateJob(const char* inName,
+                        JPH::ColorArg inColor,
+                        const JobFunction& inJobFunction,
+                        JPH::uint32 inNumDependencies = 0) override;
+
+protected:
+    void QueueJob(Job* inJob) override;
+    void QueueJobs(Job** inJobs, JPH::uint inNumJobs) override;
+    void FreeJob(Job* inJob) override;
+
+private:
+    static void runJob(void* job);
+
+    tasks::Scheduler& scheduler_;
+    JPH::FixedSizeFreeList<Job> jobs_;
+    tasks::TaskGroup queued_;
+    // Set while CreateJob waits on a full pool, so each episode warns once.
+    std::atomic<bool> pool_exhausted_{false};
+};
+
+} // namespace karma::physics_backend
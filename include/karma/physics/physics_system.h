@@ -2,17 +2,24 @@
 
 #include <string_view>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "karma/components/collider.h"
 #include "karma/components/player_controller.h"
 #include "karma/components/rigidbody.h"
 #include "karma/components/transform.h"
+#include "karma/core/frame_arena.h"
 #include "karma/ecs/world.h"
 #include "karma/physics/physics_world.hpp"
 #include "karma/systems/system.h"
 
 namespace karma::physics {
 
+// Backend bodies follow component signals rather than polling. Edits to a
+// Collider, a Rigidbody's mass or is_kinematic, or a Visibility's
+// collision_layer_mask must go through World::patch or World::add so that
+// onUpdate fires; a plain mutable get() is not seen here.
 class PhysicsSystem : public systems::ISystem {
  public:
   explicit PhysicsSystem(World& physics) : physics_(physics) {}
@@ -26,21 +33,44 @@ class PhysicsSystem : public systems::ISystem {
     math::Quat rotation{};
   };
 
+  // Collected and applied within one update, so it lives in the frame arena.
+  using TeleportList = core::FrameVector<std::pair<uint64_t, TeleportRequest>>;
+
   static uint64_t entityKey(ecs::Entity entity) {
     return (static_cast<uint64_t>(entity.index) << 32) |
            static_cast<uint64_t>(entity.generation);
   }
 
-  void syncRigidBodies(ecs::World& world);
-  void applyTeleports(ecs::World& world);
+  void bind(ecs::World& world);
+  template <typename Body>
+  static void releaseBody(std::unordered_map<uint64_t, Body>& bodies, uint64_t key) {
+    auto it = bodies.find(key);
+    if (it != bodies.end()) {
+      it->second.destroy();
+      bodies.erase(it);
+    }
+  }
+
+  void releaseRemoved();
+  void createPendingBodies(ecs::World& world);
+  void syncRigidBodies(ecs::World& world, TeleportList& teleports);
+  void applyTeleports(ecs::World& world, const TeleportList& teleports);
   void syncDynamicBodies(ecs::World& world);
   void syncPlayerController(ecs::World& world, float dt);
-  void cleanupStale(ecs::World& world);
 
   World& physics_;
+  // Storage signals feed the queues below; update() drains them, so backend
+  // bodies are created and destroyed only when components come and go.
+  ecs::World* bound_world_ = nullptr;
+  std::vector<ecs::Connection> connections_;
+  std::vector<ecs::Entity> pending_;
+  std::vector<uint64_t> removed_rigid_;
+  std::vector<uint64_t> removed_static_;
+  bool player_removed_ = false;
+  bool warned_parented_dynamic_ = false;
   std::unordered_map<uint64_t, RigidBody> rigid_bodies_;
   std::unordered_map<uint64_t, StaticBody> static_bodies_;
-  std::unordered_map<uint64_t, TeleportRequest> teleports_;
+  ecs::Tick last_tick_ = 0;
   ecs::Entity player_entity_{};
   bool has_player_ = false;
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace karma::profiling {
+
+// Nanoseconds on the steady clock.
+uint64_t nowNs();
+
+// Names the calling thread in exported traces.
+void setThreadName(std::string name);
+
+// Appends a finished zone to the calling thread's ring buffer. Each thread
+// keeps its most recent events; older ones are overwritten. name must outlive
+// the profiler's buffers: a string literal or the name of a live system.
+void recordZone(std::string_view name, uint64_t begin_ns, uint64_t end_ns);
+
+// Writes every buffered zone as Chrome trace JSON (chrome://tracing,
+// ui.perfetto.dev). Safe while other threads record; zones they overwrite
+// during the export are left out.
+void writeChromeTrace(std::ostream& out);
+bool writeChromeTrace(const std::filesystem::path& path);
+
+// Drops all buffered zones. Call while no other thread is recording.
+void clear();
+
+// Records the enclosing scope as one zone; see KARMA_PROFILE_ZONE.
+class Zone {
+ public:
+  explicit Zone(std::string_view name) : name_(name), begin_ns_(nowNs()) {}
+  ~Zone() { recordZone(name_, begin_ns_, nowNs()); }
+
+  Zone(const Zone&) = delete;
+  Zone& operator=(const Zone&) = delete;
+
+ private:
+  std::string_view name_;
+  uint64_t begin_ns_;
+};
+
+}  // namespace karma::profiling
+
+#define KARMA_PROFILE_CONCAT_INNER(a, b) a##b
+#define KARMA_PROFILE_CONCAT(a, b) KARMA_PROFILE_CONCAT_INNER(a, b)
+
+// Scoped zones nest by time: a zone opened inside another shows up beneath it.
+// Without KARMA_ENABLE_PROFILING the macros expand to nothing and the name
+// expression is not evaluated.
+#if defined(KARMA_ENABLE_PROFILING)
+#define KARMA_PROFILE_ZONE(name) \
+  const ::karma::profiling::Zone KARMA_PROFILE_CONCAT(karma_profile_zone_, __LINE__)(name)
+#define KARMA_PROFILE_THREAD(name) ::karma::profiling::setThreadName(name)
+#else
+#define KARMA_PROFILE_ZONE(name) static_cast<void>(0)
+#define KARMA_PROFILE_THREAD(name) static_cast<void>(0)
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/mat4x4.hpp>
+
+#include "karma/ecs/entity.h"
+#include "karma/renderer/types.h"
+
+namespace karma::renderer {
+
+// Render-relevant World state for one frame. RenderSystem::extract fills it
+// from the World and RenderSystem::render consumes it without touching the
+// World, so the two can run on different threads. Mesh bindings, releases and
+// instance matrices are deltas against the previous packet: render packets in
+// the order they were extracted.
+struct FramePacket {
+  // A mesh that was added or modified since the previous packet.
+  struct MeshBinding {
+    ecs::Entity entity;
+    std::string mesh_key;
+    std::string material_key;
+  };
+
+  // A drawable entity. world_matrix and max_scale are only filled in when
+  // moved is set; otherwise the renderer keeps what it cached earlier.
+  struct Instance {
+    ecs::Entity entity;
+    glm::mat4 world_matrix;
+    float max_scale;
+    bool moved;
+    bool visible;
+  };
+
+  // Set when the extracting world changed; the renderer drops all cached state.
+  bool reset = false;
+
+  bool has_camera = false;
+  CameraData camera{};
+  glm::mat4 view_projection{1.0f};
+
+  DirectionalLightData light{};
+
+  bool has_environment = false;
+  std::string environment_map;
+  float environment_intensity = 0.0f;
+  bool environment_draw_skybox = false;
+
+  std::vector<MeshBinding> meshes;
+  std::vector<ecs::Entity> released;
+  std::vector<Instance> instances;
+
+  // Resets every field; vector capacity is kept so steady-state extraction
+  // does not allocate.
+  void clear() {
+    reset = false;
+    has_camera = false;
+    camera = {};
+    view_projection = glm::mat4(1.0f);
+    light = {};
+    has_environment = false;
+    environment_map.clear();
+    environment_intensity = 0.0f;
+    environment_draw_skybox = false;
+    meshes.clear();
+    released.clear();
+    instances.clear();
+  }
+};
+
+}  // namespace karma::renderer
@@ -3,7 +3,9 @@
 #include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
+#include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
 
 #include "karma/components/mesh.h"
@@ -11,6 +13,7 @@
 #include "karma/components/visibility.h"
 #include "karma/ecs/world.h"
 #include "karma/renderer/device.h"
+#include "karma/renderer/frame_packet.h"
 #include "karma/scene/scene.h"
 
 namespace karma::renderer {
@@ -19,8 +22,21 @@ class RenderSystem {
  public:
   explicit RenderSystem(GraphicsDevice& device) : device_(device) {}
 
+  // extract() followed by render() through an internal packet.
   void update(ecs::World& world, scene::Scene& scene, float dt);
 
+  // Copies camera, light, environment and drawable state from world into
+  // packet. Reads the World only; never calls the device. Entities with a
+  // PreviousTransformComponent are placed alpha of the way from that pose to
+  // their TransformComponent; pass the fraction of a fixed step the frame runs
+  // ahead of the simulation. Other entities use their WorldMatrixComponent
+  // when TransformSystem has produced one.
+  void extract(ecs::World& world, FramePacket& packet, float alpha = 1.0f);
+
+  // Drives the device from packet without touching any World, so it may run
+  // while the next frame simulates. Packets must arrive in extraction order.
+  void render(const FramePacket& packet);
+
  private:
   struct RenderRecord {
     std::string mesh_key;
@@ -30,6 +46,14 @@ class RenderSystem {
     glm::vec3 bounds_center{0.0f};
     float bounds_radius = 0.0f;
     bool bounds_valid = false;
+    glm::mat4 world_matrix{1.0f};
+    float max_scale = 1.0f;
+    glm::vec3 world_center{0.0f};
+    float world_radius = 0.0f;
+    bool dirty = true;
+    bool submitted = false;
+    bool visible = false;
+    bool shadow_visible = false;
   };
 
   struct MeshBounds {
@@ -43,8 +67,22 @@ class RenderSystem {
            static_cast<uint64_t>(entity.generation);
   }
 
+  void bind(ecs::World& world, FramePacket& packet);
+  void createRecord(const FramePacket::MeshBinding& binding);
+  void loadMesh(RenderRecord& record, const std::string& mesh_key);
+  void releaseRecord(ecs::Entity entity);
+
   GraphicsDevice& device_;
-  std::unordered_map<uint64_t, RenderRecord> records_;
+  FramePacket packet_;
+
+  // Extraction side: touched only by extract() and World signals.
+  ecs::World* bound_world_ = nullptr;
+  std::vector<ecs::Connection> connections_;
+  std::vector<ecs::Entity> released_;
+  ecs::Tick last_tick_ = 0;
+
+  // Render side: touched only by render().
+  ecs::ComponentStorage<RenderRecord> records_;
   std::unordered_map<std::string, MeshBounds> bounds_cache_;
   std::string last_env_path_;
   float last_env_intensity_ = -1.0f;
@@ -1,7 +1,6 @@
 #pragma once
 
 #include <cstdint>
-#include <vector>
 
 #include "karma/core/id.h"
 
@@ -9,12 +8,17 @@ namespace karma::scene {
 
 using NodeId = uint32_t;
 
+// A node's links. Children form a doubly linked sibling list in attach order,
+// so attaching and detaching a node touches a fixed number of entries.
 struct Node {
   static constexpr NodeId kInvalidId = 0xFFFFFFFFu;
 
   NodeId id = kInvalidId;
   NodeId parent = kInvalidId;
-  std::vector<NodeId> children;
+  NodeId first_child = kInvalidId;
+  NodeId last_child = kInvalidId;
+  NodeId next_sibling = kInvalidId;
+  NodeId prev_sibling = kInvalidId;
   core::EntityId entity;
 };
 
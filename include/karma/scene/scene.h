@@ -1,74 +1,75 @@
 #pragma once
 
-#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "karma/scene/node.h"
 
 namespace karma::scene {
 
+// Live nodes flattened in preorder: every parent precedes its children and the
+// subtree rooted at position i is [i, subtree_end[i]). The arrays are parallel
+// and indexed by position, so propagation and queries are linear scans.
+struct SortedHierarchy {
+  static constexpr uint32_t kNoParent = 0xFFFFFFFFu;
+
+  std::vector<NodeId> nodes;
+  // Position of the parent, kNoParent for roots.
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> subtree_end;
+  std::vector<uint32_t> depths;
+  std::vector<core::EntityId> entities;
+
+  size_t size() const { return nodes.size(); }
+};
+
 class Scene {
  public:
-  NodeId createNode(core::EntityId entity = {}) {
-    if (!free_list_.empty()) {
-      const NodeId id = free_list_.back();
-      free_list_.pop_back();
-      nodes_[id] = Node{.id = id, .parent = Node::kInvalidId, .children = {}, .entity = entity};
-      return id;
-    }
-    const NodeId id = static_cast<NodeId>(nodes_.size());
-    nodes_.push_back(Node{.id = id, .parent = Node::kInvalidId, .children = {}, .entity = entity});
-    return id;
-  }
+  NodeId createNode(core::EntityId entity = {});
 
-  void destroyNode(NodeId id) {
-    if (!isAlive(id)) {
-      return;
-    }
-    detachFromParent(id);
-    for (NodeId child : nodes_[id].children) {
-      if (isAlive(child)) {
-        nodes_[child].parent = Node::kInvalidId;
-      }
-    }
-    nodes_[id].children.clear();
-    nodes_[id].id = Node::kInvalidId;
-    free_list_.push_back(id);
-  }
+  // Children of a destroyed node become roots.
+  void destroyNode(NodeId id);
 
-  void reparent(NodeId child, NodeId new_parent) {
-    if (!isAlive(child)) {
-      return;
-    }
-    detachFromParent(child);
-    nodes_[child].parent = new_parent;
-    if (isAlive(new_parent)) {
-      nodes_[new_parent].children.push_back(child);
-    }
-  }
+  // O(depth of new_parent). Passing an invalid or dead new_parent makes child
+  // a root. Returns false, leaving the scene unchanged, when child is dead or
+  // new_parent lies in child's subtree.
+  bool reparent(NodeId child, NodeId new_parent);
+
+  void setEntity(NodeId id, core::EntityId entity);
 
   bool isAlive(NodeId id) const {
     return id < nodes_.size() && nodes_[id].id != Node::kInvalidId;
   }
 
-  Node& get(NodeId id) { return nodes_[id]; }
-
   const Node& get(NodeId id) const { return nodes_[id]; }
 
+  // Ids below capacity() are either live nodes or free slots (see isAlive).
+  size_t capacity() const { return nodes_.size(); }
+
+  // Bumped by every structural change and setEntity.
+  uint64_t revision() const { return revision_; }
+
+  // Re-sorted on the first call after a structural change, so a burst of
+  // reparents costs one linear pass. Any create, destroy or reparent pays a
+  // full O(N) re-sort; setEntity patches the sorted entities in place.
+  const SortedHierarchy& sorted() const;
+
  private:
-  void detachFromParent(NodeId id) {
-    const NodeId parent = nodes_[id].parent;
-    if (!isAlive(parent)) {
-      nodes_[id].parent = Node::kInvalidId;
-      return;
-    }
-    auto& siblings = nodes_[parent].children;
-    siblings.erase(std::remove(siblings.begin(), siblings.end(), id), siblings.end());
-    nodes_[id].parent = Node::kInvalidId;
+  void detachFromParent(NodeId id);
+  void changed() {
+    ++revision_;
+    sorted_valid_ = false;
   }
+  bool isAncestorOrSelf(NodeId ancestor, NodeId id) const;
 
   std::vector<Node> nodes_;
   std::vector<NodeId> free_list_;
+  uint64_t revision_ = 0;
+  mutable SortedHierarchy sorted_;
+  // Node id -> sorted position, scratch for sorted().
+  mutable std::vector<uint32_t> positions_;
+  mutable bool sorted_valid_ = false;
 };
 
 }  // namespace karma::scene
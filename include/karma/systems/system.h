@@ -1,17 +1,72 @@
 #pragma once
 
+#include <algorithm>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 
+#include "karma/core/type_id.h"
 #include "karma/ecs/world.h"
 
 namespace karma::systems {
 
+// Component types a system reads and writes. SystemGraph runs two systems
+// concurrently only when neither writes a type the other touches. In a
+// sparse-set World a system may add and remove components of the types it
+// writes. Creating or destroying entities, touching any other storage
+// structurally, advancing the world tick or touching state shared outside the
+// World needs exclusive access.
+class SystemAccess {
+ public:
+  static SystemAccess exclusive() {
+    SystemAccess access;
+    access.exclusive_ = true;
+    return access;
+  }
+
+  template <typename... Ts>
+  SystemAccess& read() {
+    (reads_.push_back(core::typeId<std::remove_const_t<Ts>>()), ...);
+    return *this;
+  }
+
+  template <typename... Ts>
+  SystemAccess& write() {
+    (writes_.push_back(core::typeId<std::remove_const_t<Ts>>()), ...);
+    return *this;
+  }
+
+  bool isExclusive() const { return exclusive_; }
+
+  bool conflictsWith(const SystemAccess& other) const {
+    if (exclusive_ || other.exclusive_) {
+      return true;
+    }
+    return overlaps(writes_, other.writes_) || overlaps(writes_, other.reads_) ||
+           overlaps(reads_, other.writes_);
+  }
+
+ private:
+  static bool overlaps(const std::vector<core::TypeId>& a, const std::vector<core::TypeId>& b) {
+    return std::any_of(a.begin(), a.end(),
+                       [&](core::TypeId id) { return std::find(b.begin(), b.end(), id) != b.end(); });
+  }
+
+  bool exclusive_ = false;
+  std::vector<core::TypeId> reads_;
+  std::vector<core::TypeId> writes_;
+};
+
 class ISystem {
  public:
   virtual ~ISystem() = default;
 
   virtual std::string_view name() const = 0;
   virtual void update(ecs::World& world, float dt) = 0;
+
+  // Queried when SystemGraph rebuilds its schedule. Systems that do not
+  // declare their access never run alongside another system.
+  virtual SystemAccess access() const { return SystemAccess::exclusive(); }
 };
 
 }  // namespace karma::systems
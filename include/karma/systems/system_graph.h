@@ -1,101 +1,85 @@
 #pragma once
 
 #include <cstdint>
+#include <exception>
 #include <memory>
-#include <queue>
-#include <unordered_map>
-#include <utility>
+#include <mutex>
 #include <vector>
 
 #include "karma/systems/system.h"
+#include "karma/tasks/scheduler.h"
 
 namespace karma::systems {
 
 using SystemId = uint32_t;
 
+// Runs systems in a topological order of their explicit dependencies. Systems
+// whose declared access conflicts (see SystemAccess) also keep their relative
+// serial order: independent systems in insertion order. Systems with no
+// ordering between them run concurrently on the task scheduler's workers;
+// among the systems that are ready, the one heading the costliest remaining
+// chain (measured over previous updates) starts first. The schedule is built on
+// the first update after the graph changes and reused until the next change.
 class SystemGraph {
  public:
-  SystemId addSystem(std::unique_ptr<ISystem> system) {
-    const SystemId id = next_id_++;
-    nodes_[id] = Node{.id = id, .system = std::move(system), .depends_on = {}};
-    insertion_order_.push_back(id);
-    return id;
-  }
+  // Uses the engine-wide tasks::scheduler() when scheduler is null.
+  explicit SystemGraph(tasks::Scheduler* scheduler = nullptr);
 
-  void addDependency(SystemId system, SystemId depends_on) {
-    nodes_[system].depends_on.push_back(depends_on);
-  }
+  SystemGraph(const SystemGraph&) = delete;
+  SystemGraph& operator=(const SystemGraph&) = delete;
 
-  void update(ecs::World& world, float dt) {
-    const auto order = buildOrder();
-    for (SystemId id : order) {
-      if (nodes_[id].system) {
-        nodes_[id].system->update(world, dt);
-      }
-    }
-  }
+  SystemId addSystem(std::unique_ptr<ISystem> system);
+  void addDependency(SystemId system, SystemId depends_on);
+
+  // Throws std::logic_error naming the unscheduled systems if the dependencies
+  // contain a cycle. If a system throws, systems that have not started yet are
+  // skipped and the exception is rethrown once the running ones finish.
+  void update(ecs::World& world, float dt);
 
  private:
   struct Node {
-    SystemId id = 0;
     std::unique_ptr<ISystem> system;
-    std::vector<SystemId> depends_on;
+    std::vector<uint32_t> dependents;
+    uint32_t dependency_count = 0;
+    // Schedule edges: explicit dependents plus later conflicting systems.
+    std::vector<uint32_t> successors;
+    uint32_t predecessor_count = 0;
+    float cost_ns = 1.0f;
+    float priority = 0.0f;
   };
 
-  std::vector<SystemId> buildOrder() const {
-    std::unordered_map<SystemId, uint32_t> indegree;
-    for (const auto& [id, node] : nodes_) {
-      indegree[id] = 0;
-    }
-    for (const auto& [id, node] : nodes_) {
-      for (SystemId dep : node.depends_on) {
-        if (nodes_.find(dep) != nodes_.end()) {
-          indegree[id]++;
-        }
-      }
-    }
-
-    std::queue<SystemId> ready;
-    for (const auto& [id, count] : indegree) {
-      if (count == 0) {
-        ready.push(id);
-      }
-    }
-
-    std::vector<SystemId> order;
-    order.reserve(nodes_.size());
-    while (!ready.empty()) {
-      const SystemId id = ready.front();
-      ready.pop();
-      order.push_back(id);
-      for (SystemId dependent : dependentsOf(id)) {
-        if (--indegree[dependent] == 0) {
-          ready.push(dependent);
-        }
-      }
-    }
+  // Per-update state shared by the lanes; kept across updates so the steady
+  // state does not allocate.
+  struct Run {
+    std::mutex mutex;
+    std::vector<uint32_t> ready;
+    std::vector<uint32_t> pending;
+    size_t lanes = 0;
+    size_t max_lanes = 0;
+    std::exception_ptr error;
+    ecs::World* world = nullptr;
+    float dt = 0.0f;
+    tasks::Scheduler* scheduler = nullptr;
+    tasks::TaskGroup group;
+  };
 
-    if (order.size() != nodes_.size()) {
-      return insertion_order_;
-    }
-    return order;
-  }
+  bool contains(SystemId id) const { return id != 0 && id <= nodes_.size(); }
 
-  std::vector<SystemId> dependentsOf(SystemId id) const {
-    std::vector<SystemId> dependents;
-    for (const auto& [node_id, node] : nodes_) {
-      for (SystemId dep : node.depends_on) {
-        if (dep == id) {
-          dependents.push_back(node_id);
-        }
-      }
-    }
-    return dependents;
-  }
+  void buildOrder();
+  void buildSchedule();
+  void updatePriorities();
+  void runParallel(ecs::World& world, float dt, tasks::Scheduler& scheduler);
+  void runLane();
+  void spawnLanes(size_t count);
+  static void laneTask(void* graph);
 
-  SystemId next_id_ = 1;
-  std::unordered_map<SystemId, Node> nodes_;
-  std::vector<SystemId> insertion_order_;
+  tasks::Scheduler* scheduler_ = nullptr;
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> order_;
+  bool order_valid_ = true;
+  // False when the schedule is a single chain and nothing can overlap.
+  bool has_parallelism_ = false;
+  Run run_;
 };
 
 }  // namespace karma::systems
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "karma/components/transform.h"
+#include "karma/components/world_matrix.h"
+#include "karma/ecs/world.h"
+#include "karma/math/mat4.h"
+#include "karma/scene/scene.h"
+#include "karma/systems/system.h"
+
+namespace karma::systems {
+
+// Keeps a WorldMatrixComponent next to every TransformComponent. Entities
+// attached to scene nodes treat their TransformComponent as relative to the
+// nearest ancestor node; nodes without a transformed entity pass their
+// parent's matrix through. Each update walks Scene::sorted() and recomputes
+// only the entities whose TransformComponent changed since the last one, plus
+// everything below them, skipping subtrees with nothing dirty.
+//
+// Rigid bodies are simulated in world space, so dynamic bodies should not have
+// a transformed ancestor.
+class TransformSystem : public ISystem {
+ public:
+  explicit TransformSystem(const scene::Scene& scene) : scene_(scene) {}
+
+  std::string_view name() const override { return "TransformSystem"; }
+  void update(ecs::World& world, float dt) override;
+  SystemAccess access() const override {
+    return SystemAccess()
+        .read<components::TransformComponent>()
+        .write<components::WorldMatrixComponent>();
+  }
+
+ private:
+  static constexpr uint32_t kNone = scene::SortedHierarchy::kNoParent;
+
+  enum Flags : uint8_t {
+    kDirty = 1,  // own TransformComponent changed
+    kBelow = 2,  // some descendant is dirty
+    kMoved = 4,  // recomputed during this update
+  };
+
+  void bind(ecs::World& world);
+  void rebuild(ecs::World& world);
+  uint32_t slotOf(ecs::Entity entity) const;
+  void markDirty(const scene::SortedHierarchy& hierarchy, uint32_t slot);
+  void setFlags(uint32_t slot, uint8_t flags);
+  void store(ecs::World& world, ecs::Entity entity, const math::Mat4& matrix);
+
+  const scene::Scene& scene_;
+  ecs::World* bound_world_ = nullptr;
+  std::vector<ecs::Connection> connections_;
+  std::vector<ecs::Entity> removed_;
+  ecs::Tick last_tick_ = 0;
+
+  // Slots are positions in scene_.sorted() as of scene_revision_.
+  uint64_t scene_revision_ = 0;
+  bool built_ = false;
+  std::vector<ecs::Entity> entities_;
+  std::vector<math::Mat4> matrices_;
+  std::vector<uint8_t> flags_;
+  // Slots with non-zero flags, cleared at the end of each update.
+  std::vector<uint32_t> touched_;
+  // Entity index -> slot, kNone when the entity has no node.
+  std::vector<uint32_t> slot_of_;
+};
+
+}  // namespace karma::systems
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace karma::tasks {
+
+// One dedicated thread that runs a job at a time, for work that has to overlap
+// the calling thread for its whole duration. Scheduler::parallelFor cannot do
+// that: its caller joins in and blocks. The thread starts on the first run().
+class BackgroundJob {
+ public:
+  using JobFn = void (*)(void* context);
+
+  BackgroundJob() = default;
+  ~BackgroundJob();
+
+  BackgroundJob(const BackgroundJob&) = delete;
+  BackgroundJob& operator=(const BackgroundJob&) = delete;
+
+  // Starts fn(context) on the background thread. Nothing is copied or
+  // allocated, so context must stay valid until wait() returns. The previous
+  // job must have been waited for.
+  void run(JobFn fn, void* context);
+
+  // Blocks until the current job has finished; rethrows anything it threw.
+  // Returns immediately when no job is running.
+  void wait();
+
+ private:
+  void loop();
+
+  std::thread thread_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  JobFn job_ = nullptr;
+  void* context_ = nullptr;
+  std::exception_ptr error_;
+  bool busy_ = false;
+  bool stopping_ = false;
+};
+
+}  // namespace karma::tasks
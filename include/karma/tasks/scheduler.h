@@ -0,0 +1,180 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace karma::tasks {
+
+class Scheduler;
+
+// Tracks a set of submitted tasks so a caller can wait for all of them.
+class TaskGroup {
+ public:
+  TaskGroup() = default;
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  bool done() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+ private:
+  friend class Scheduler;
+
+  std::atomic<size_t> pending_{0};
+  std::atomic<bool> failed_{false};
+  std::exception_ptr error_;
+};
+
+// Tasks with ordering constraints, built once and run any number of times with
+// Scheduler::run. A task starts once every task that precedes it has finished.
+class TaskGraph {
+ public:
+  using TaskId = uint32_t;
+
+  TaskId add(std::function<void()> func);
+  // before finishes before after starts.
+  void precede(TaskId before, TaskId after);
+
+  size_t size() const { return nodes_.size(); }
+
+ private:
+  friend class Scheduler;
+
+  struct Node {
+    std::function<void()> func;
+    std::vector<TaskId> successors;
+    uint32_t predecessor_count = 0;
+    std::atomic<uint32_t> pending{0};
+  };
+
+  struct Launch {
+    TaskGraph* graph;
+    TaskId task;
+  };
+
+  // std::deque keeps nodes in place as the graph grows; the atomics cannot move.
+  std::deque<Node> nodes_;
+  std::vector<Launch> launches_;
+  bool validated_ = true;
+  // Set for the duration of Scheduler::run; a graph runs once at a time.
+  Scheduler* scheduler_ = nullptr;
+  TaskGroup* group_ = nullptr;
+};
+
+// Engine-wide worker pool. Each worker owns a task queue; tasks submitted from
+// a worker go to its own queue and run newest-first, idle workers steal the
+// oldest task from another queue, and tasks from other threads go to a shared
+// queue. Waiting threads run queued tasks until their group is done, so tasks
+// may submit and wait for further tasks without deadlocking the pool.
+class Scheduler {
+ public:
+  using TaskFn = void (*)(void* context);
+
+  // Non-owning reference to a callable(begin, end, chunk_index). Unlike
+  // std::function, binding one never allocates; the callable must outlive it.
+  class RangeFn {
+   public:
+    template <typename Func,
+              typename = std::enable_if_t<!std::is_same_v<std::decay_t<Func>, RangeFn>>>
+    RangeFn(Func&& func) noexcept
+        : object_(const_cast<void*>(static_cast<const void*>(std::addressof(func)))),
+          call_(&invoke<std::remove_reference_t<Func>>) {}
+
+    void operator()(size_t begin, size_t end, size_t chunk_index) const {
+      call_(object_, begin, end, chunk_index);
+    }
+
+   private:
+    template <typename Func>
+    static void invoke(void* object, size_t begin, size_t end, size_t chunk_index) {
+      (*static_cast<Func*>(object))(begin, end, chunk_index);
+    }
+
+    void* object_;
+    void (*call_)(void* object, size_t begin, size_t end, size_t chunk_index);
+  };
+
+  explicit Scheduler(unsigned worker_count = defaultWorkerCount());
+  ~Scheduler();
+
+  Scheduler(const Scheduler&) = delete;
+  Scheduler& operator=(const Scheduler&) = delete;
+
+  static unsigned defaultWorkerCount();
+
+  unsigned workerCount() const { return static_cast<unsigned>(workers_.size()); }
+
+  // Queues fn(context) as part of group; context must stay valid until the
+  // task has run.
+  void submit(TaskGroup& group, TaskFn fn, void* context);
+
+  // Runs queued tasks on the calling thread until every task in group has
+  // finished, then rethrows the first exception one of them threw.
+  void wait(TaskGroup& group);
+
+  // Splits [0, count) into fixed chunks [i * chunk_size, min(count, (i + 1) *
+  // chunk_size)); the calling thread works on chunks too and returns once every
+  // chunk has run.
+  void parallelFor(size_t count, size_t chunk_size, const RangeFn& func);
+
+  // Runs every task of graph and waits for them. Throws std::logic_error if the
+  // ordering constraints contain a cycle.
+  void run(TaskGraph& graph);
+
+ private:
+  struct Task {
+    TaskFn fn;
+    void* context;
+    TaskGroup* group;
+  };
+
+  // Ring buffer that keeps its capacity, so a steady load never allocates; a
+  // std::deque used as a queue frees and reallocates blocks as it drains.
+  class TaskQueue {
+   public:
+    bool empty() const { return size_ == 0; }
+    void pushBack(const Task& task);
+    Task popBack();
+    Task popFront();
+
+   private:
+    std::vector<Task> slots_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+  };
+
+  struct Worker {
+    std::mutex mutex;
+    TaskQueue tasks;
+    std::thread thread;
+  };
+
+  void workerLoop(size_t index);
+  void push(const Task& task);
+  bool pop(Task& out);
+  bool steal(size_t thief, Task& out);
+  static void execute(const Task& task);
+  static void runGraphTask(void* context);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::mutex shared_mutex_;
+  TaskQueue shared_tasks_;
+  std::atomic<size_t> queued_{0};
+  std::atomic<unsigned> sleepers_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::atomic<bool> stopping_{false};
+};
+
+Scheduler& scheduler();
+
+}  // namespace karma::tasks
@@ -1,8 +1,15 @@
 #include "karma/app/engine_app.h"
 
+#include <algorithm>
 #include <chrono>
+#include <random>
+#include <stdexcept>
+#include <utility>
 #include <spdlog/spdlog.h>
 
+#include "karma/core/frame_arena.h"
+#include "karma/profiling/profiler.h"
+
 namespace karma::app {
 
 EngineApp::EngineApp() = default;
@@ -15,6 +22,18 @@ EngineApp::~EngineApp() {
 }
 
 void EngineApp::initSubsystems() {
+  // Fixed steps refresh world matrices before physics reads them, so
+  // transforms written in onFixedUpdate reach the backend in the same step.
+  auto transforms = std::make_unique<systems::TransformSystem>(scene_);
+  transforms_ = transforms.get();
+  const systems::SystemId transform_id = systems_.addSystem(std::move(transforms));
+  const systems::SystemId physics_id =
+      systems_.addSystem(std::make_unique<physics::PhysicsSystem>(physics_));
+  systems_.addDependency(physics_id, transform_id);
+  if (config_.headless || replaying()) {
+    return;
+  }
+
   window_ = platform::CreateWindow(config_.window);
   if (window_) {
     window_->setVsync(config_.vsync);
@@ -25,19 +44,39 @@ void EngineApp::initSubsystems() {
     }
   }
 
-  input_.setWindow(window_.get());
-
   if (window_) {
     graphics_ = std::make_unique<renderer::GraphicsDevice>(*window_);
     render_system_ = std::make_unique<renderer::RenderSystem>(*graphics_);
   }
 
-  systems_.addSystem(std::make_unique<physics::PhysicsSystem>(physics_));
-  audio_system_ = std::make_unique<audio::AudioSystem>(audio_);
+  audio_ = std::make_unique<audio::Audio>();
+  audio_system_ = std::make_unique<audio::AudioSystem>(*audio_);
   // Register other systems here (PhysicsSystem, AudioSystem, etc.).
 }
 
 void EngineApp::shutdownSubsystems() {
+  if (game_) {
+    const core::FrameArenaStats arenas = core::frameArenaStats();
+    spdlog::info("Karma: Frame arenas peaked at {} KiB of {} KiB over {} threads; {} heap fallbacks.",
+                 arenas.high_water_bytes / 1024, arenas.capacity_bytes / 1024, arenas.threads,
+                 arenas.overflow_count);
+  }
+  if (game_ && !config_.record_input_path.empty() && !replaying()) {
+    try {
+      saveInputRecording(recording_, config_.record_input_path);
+      spdlog::info("Karma: Recorded {} frames to {}.", recording_.frames.size(),
+                   config_.record_input_path.string());
+    } catch (const std::runtime_error& error) {
+      spdlog::error("Karma: {}", error.what());
+    }
+  }
+  if (game_ && !config_.profile_trace_path.empty()) {
+    if (profiling::writeChromeTrace(config_.profile_trace_path)) {
+      spdlog::info("Karma: Wrote profile trace to {}.", config_.profile_trace_path.string());
+    } else {
+      spdlog::error("Karma: Failed to write profile trace to {}.", config_.profile_trace_path.string());
+    }
+  }
   if (ui_) {
     ui_->onShutdown();
     ui_.reset();
@@ -61,8 +100,24 @@ void EngineApp::start(GameInterface& game, const EngineConfig& config) {
     return;
   }
   spdlog::set_level(spdlog::level::info);
+  KARMA_PROFILE_THREAD("Main");
   config_ = config;
   fixed_dt_ = config_.fixed_dt;
+  if (replaying()) {
+    // Throws before anything starts if the recording cannot be read.
+    replay_ = loadInputRecording(config_.replay_input_path);
+    replay_frame_ = 0;
+    replay_frame_seconds_.clear();
+    replay_frame_seconds_.reserve(replay_.frames.size());
+    config_.random_seed = replay_.seed;
+    fixed_dt_ = replay_.fixed_dt;
+  } else if (config_.random_seed == 0) {
+    std::random_device device;
+    config_.random_seed = (static_cast<uint64_t>(device()) << 32) | device();
+  }
+  recording_ = {};
+  recording_.seed = config_.random_seed;
+  recording_.fixed_dt = fixed_dt_;
   initSubsystems();
   if (graphics_) {
     graphics_->setGenerateMips(config_.generate_mipmaps);
@@ -77,7 +132,13 @@ void EngineApp::start(GameInterface& game, const EngineConfig& config) {
   running_ = true;
   accumulator_ = 0.0f;
   last_time_ = std::chrono::steady_clock::now();
-  game_->bindContext(world_, scene_, input_, physics_, graphics_.get());
+  next_tick_ = last_time_;
+  next_report_ = last_time_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                  std::chrono::duration<float>(config_.headless_report_interval));
+  headless_stats_ = {};
+  reported_stats_ = {};
+  interval_max_tick_seconds_ = 0.0;
+  game_->bindContext(world_, scene_, input_, physics_, graphics_.get(), config_.random_seed);
   game_->onStart();
 }
 
@@ -89,6 +150,17 @@ void EngineApp::tick() {
   if (!running_ || !game_) {
     return;
   }
+  KARMA_PROFILE_ZONE("EngineApp::tick");
+  // The previous tick, including its pipelined simulation, has finished.
+  core::resetFrameArenas();
+  if (config_.headless) {
+    tickHeadless();
+    return;
+  }
+  if (replaying()) {
+    tickReplay();
+    return;
+  }
 
   const auto now = std::chrono::steady_clock::now();
   float frame_dt = std::chrono::duration<float>(now - last_time_).count();
@@ -97,6 +169,11 @@ void EngineApp::tick() {
   }
   last_time_ = now;
   accumulator_ += frame_dt;
+  RecordedFrame* recorded = nullptr;
+  if (!config_.record_input_path.empty()) {
+    recorded = &recording_.frames.emplace_back();
+    recorded->dt = frame_dt;
+  }
 
   if (window_) {
     window_->pollEvents();
@@ -106,6 +183,9 @@ void EngineApp::tick() {
       }
     }
     input_.update(window_->events());
+    if (recorded) {
+      recorded->events = window_->events();
+    }
     window_->clearEvents();
     if (window_->shouldClose()) {
       requestStop();
@@ -121,6 +201,125 @@ void EngineApp::tick() {
     return;
   }
 
+  if (config_.pipelined_rendering && render_system_) {
+    simulatePipelined(frame_dt);
+  } else {
+    simulate(frame_dt);
+    if (render_system_) {
+      render_system_->extract(world_, packets_[front_packet_], accumulator_ / fixed_dt_);
+      updateUi(frame_dt);
+      renderFrame(frame_dt, packets_[front_packet_]);
+    }
+  }
+
+  if (!running_) {
+    if (game_) {
+      game_->onShutdown();
+    }
+    shutdownSubsystems();
+    game_ = nullptr;
+  }
+}
+
+void EngineApp::tickHeadless() {
+  using Clock = std::chrono::steady_clock;
+  const auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(fixed_dt_));
+  const auto max_lag = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(config_.max_frame_dt));
+
+  const FramePacer::Wait wait = pacer_.waitUntil(next_tick_);
+  headless_stats_.sleep_seconds += std::chrono::duration<double>(wait.slept).count();
+  headless_stats_.spin_seconds += std::chrono::duration<double>(wait.spun).count();
+
+  const Clock::time_point start = Clock::now();
+  if (start - next_tick_ > max_lag) {
+    // Too far behind to catch up; drop the missed steps and resync.
+    headless_stats_.skipped_steps += static_cast<uint64_t>((start - next_tick_) / period);
+    next_tick_ = start;
+  }
+
+  game_->onFixedUpdate(fixed_dt_);
+  systems_.update(world_, fixed_dt_);
+  game_->onUpdate(fixed_dt_);
+  transforms_->update(world_, fixed_dt_);
+
+  const Clock::time_point end = Clock::now();
+  const double busy = std::chrono::duration<double>(end - start).count();
+  headless_stats_.busy_seconds += busy;
+  headless_stats_.max_tick_seconds = std::max(headless_stats_.max_tick_seconds, busy);
+  interval_max_tick_seconds_ = std::max(interval_max_tick_seconds_, busy);
+  ++headless_stats_.ticks;
+  if (end - start > period) {
+    ++headless_stats_.overruns;
+  }
+  // Late ticks leave next_tick_ in the past, so the following ones run
+  // back to back until the schedule is met again.
+  next_tick_ += period;
+
+  if (config_.headless_report_interval > 0.0f && end >= next_report_) {
+    reportHeadless();
+    next_report_ = end + std::chrono::duration_cast<Clock::duration>(
+                             std::chrono::duration<float>(config_.headless_report_interval));
+  }
+
+  if (!running_) {
+    if (game_) {
+      game_->onShutdown();
+    }
+    shutdownSubsystems();
+    game_ = nullptr;
+  }
+}
+
+// Runs the next recorded frame as fast as possible: the recorded dt drives the
+// fixed-step accumulator, so the simulation sees the same steps it did live.
+void EngineApp::tickReplay() {
+  if (replay_frame_ < replay_.frames.size()) {
+    const RecordedFrame& frame = replay_.frames[replay_frame_++];
+    const auto start = std::chrono::steady_clock::now();
+    input_.update(frame.events);
+    accumulator_ += frame.dt;
+    simulate(frame.dt);
+    replay_frame_seconds_.push_back(
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+  if (replay_frame_ == replay_.frames.size()) {
+    requestStop();
+  }
+
+  if (!running_) {
+    if (game_) {
+      game_->onShutdown();
+    }
+    shutdownSubsystems();
+    game_ = nullptr;
+  }
+}
+
+// Logs the counters accumulated since the previous report.
+void EngineApp::reportHeadless() {
+  const HeadlessStats& now = headless_stats_;
+  const HeadlessStats& then = reported_stats_;
+  HeadlessStats interval;
+  interval.busy_seconds = now.busy_seconds - then.busy_seconds;
+  interval.sleep_seconds = now.sleep_seconds - then.sleep_seconds;
+  interval.spin_seconds = now.spin_seconds - then.spin_seconds;
+  const uint64_t ticks = now.ticks - then.ticks;
+  const uint64_t overruns = now.overruns - then.overruns;
+  const uint64_t skipped = now.skipped_steps - then.skipped_steps;
+  const double mean_ms = ticks > 0 ? interval.busy_seconds * 1000.0 / static_cast<double>(ticks) : 0.0;
+  if (overruns > 0 || skipped > 0) {
+    spdlog::warn("Karma: {} of {} ticks overran {:.2f} ms; {} steps skipped; worst tick {:.2f} ms.", overruns,
+                 ticks, fixed_dt_ * 1000.0f, skipped, interval_max_tick_seconds_ * 1000.0);
+  }
+  const double spin_share = interval.wallSeconds() > 0.0 ? interval.spin_seconds / interval.wallSeconds() : 0.0;
+  spdlog::info("Karma: {} ticks, mean {:.3f} ms, idle {:.1f}%, spinning {:.1f}%.", ticks, mean_ms,
+               interval.idleFraction() * 100.0, spin_share * 100.0);
+  reported_stats_ = headless_stats_;
+  interval_max_tick_seconds_ = 0.0;
+}
+
+void EngineApp::simulate(float frame_dt) {
+  KARMA_PROFILE_ZONE("EngineApp::simulate");
   while (accumulator_ >= fixed_dt_) {
     game_->onFixedUpdate(fixed_dt_);
     // Physics runs via SystemGraph.
@@ -129,49 +328,80 @@ void EngineApp::tick() {
   }
 
   game_->onUpdate(frame_dt);
+  transforms_->update(world_, frame_dt);
   if (audio_system_) {
     audio_system_->update(world_, frame_dt);
   }
-  if (graphics_ && render_system_) {
-    int fb_width = 0;
-    int fb_height = 0;
-    if (window_) {
-      window_->getFramebufferSize(fb_width, fb_height);
-    }
-    if (ui_) {
-      ui_context_.frame_.dt = frame_dt;
-      ui_context_.frame_.viewport_w = fb_width;
-      ui_context_.frame_.viewport_h = fb_height;
-      ui_context_.frame_.dpi_scale = window_ ? window_->getContentScale() : 1.0f;
-      ui_context_.draw_data_.clear();
-      ui_context_.input_ = &input_;
-      ui_context_.device_ = graphics_.get();
-      ui_->onFrame(ui_context_);
-    }
-    renderer::FrameInfo frame{};
-    frame.width = fb_width;
-    frame.height = fb_height;
-    frame.delta_time = frame_dt;
-    graphics_->beginFrame(frame);
-    render_system_->update(world_, scene_, frame_dt);
-    graphics_->renderLayer(0);
-    if (ui_) {
-      graphics_->renderUi(ui_context_.draw_data_);
-    }
-    graphics_->endFrame();
-    if (window_) {
-#if !defined(BZ3_RENDER_BACKEND_DILIGENT)
-      window_->swapBuffers();
-#endif
-    }
+}
+
+// Frame N+1's whole simulate-and-extract sequence runs as one background job
+// while frame N's packet is submitted here, and is joined before the packets
+// swap. Input and the UI are updated before the job starts, and renderFrame
+// touches only the packet and the GraphicsDevice, so game callbacks never run
+// concurrently with input, the UI or each other.
+void EngineApp::simulatePipelined(float frame_dt) {
+  KARMA_PROFILE_ZONE("EngineApp::simulatePipelined");
+  const renderer::FramePacket& front = packets_[front_packet_];
+  renderer::FramePacket& back = packets_[1 - front_packet_];
+
+  // The UI sees the World as of the packet it is drawn over.
+  updateUi(frame_dt);
+  auto job = [this, frame_dt, &back] {
+    simulate(frame_dt);
+    render_system_->extract(world_, back, accumulator_ / fixed_dt_);
+  };
+  simulation_.run([](void* context) { (*static_cast<decltype(job)*>(context))(); }, &job);
+  renderFrame(frame_dt, front);
+  simulation_.wait();
+  front_packet_ = 1 - front_packet_;
+}
+
+void EngineApp::updateUi(float frame_dt) {
+  if (!graphics_ || !ui_) {
+    return;
+  }
+  int fb_width = 0;
+  int fb_height = 0;
+  if (window_) {
+    window_->getFramebufferSize(fb_width, fb_height);
   }
+  ui_context_.frame_.dt = frame_dt;
+  ui_context_.frame_.viewport_w = fb_width;
+  ui_context_.frame_.viewport_h = fb_height;
+  ui_context_.frame_.dpi_scale = window_ ? window_->getContentScale() : 1.0f;
+  ui_context_.draw_data_.clear();
+  ui_context_.input_ = &input_;
+  ui_context_.device_ = graphics_.get();
+  ui_->onFrame(ui_context_);
+}
 
-  if (!running_) {
-    if (game_) {
-      game_->onShutdown();
-    }
-    shutdownSubsystems();
-    game_ = nullptr;
+// Submits packet and the UI draw data from updateUi() without touching the
+// World, input or game state.
+void EngineApp::renderFrame(float frame_dt, const renderer::FramePacket& packet) {
+  if (!graphics_) {
+    return;
+  }
+  KARMA_PROFILE_ZONE("EngineApp::renderFrame");
+  int fb_width = 0;
+  int fb_height = 0;
+  if (window_) {
+    window_->getFramebufferSize(fb_width, fb_height);
+  }
+  renderer::FrameInfo frame{};
+  frame.width = fb_width;
+  frame.height = fb_height;
+  frame.delta_time = frame_dt;
+  graphics_->beginFrame(frame);
+  render_system_->render(packet);
+  graphics_->renderLayer(0);
+  if (ui_) {
+    graphics_->renderUi(ui_context_.draw_data_);
+  }
+  graphics_->endFrame();
+  if (window_) {
+#if !defined(BZ3_RENDER_BACKEND_DILIGENT)
+    window_->swapBuffers();
+#endif
   }
 }
 
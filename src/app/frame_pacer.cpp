@@ -0,0 +1,48 @@
+#include "karma/app/frame_pacer.h"
+
+#include <cmath>
+#include <thread>
+
+namespace karma::app {
+namespace {
+
+constexpr auto kSleepSlice = std::chrono::milliseconds(1);
+// Caps the sample count so the estimate keeps adapting to timer changes.
+constexpr double kMaxSamples = 1000.0;
+
+}  // namespace
+
+FramePacer::Wait FramePacer::waitUntil(Clock::time_point deadline) {
+  Wait wait;
+  Clock::time_point now = Clock::now();
+  while (std::chrono::duration<double>(deadline - now).count() > estimate_) {
+    const Clock::time_point start = now;
+    std::this_thread::sleep_for(kSleepSlice);
+    now = Clock::now();
+    wait.slept += now - start;
+    observe(std::chrono::duration<double>(now - start).count());
+  }
+  const Clock::time_point spin_start = now;
+  while (now < deadline) {
+    std::this_thread::yield();
+    now = Clock::now();
+  }
+  wait.spun = now - spin_start;
+  return wait;
+}
+
+// Welford's running mean and variance of actual slice lengths.
+void FramePacer::observe(double slice_seconds) {
+  if (count_ < kMaxSamples) {
+    count_ += 1.0;
+  }
+  const double delta = slice_seconds - mean_;
+  mean_ += delta / count_;
+  m2_ += delta * (slice_seconds - mean_);
+  if (count_ >= kMaxSamples) {
+    m2_ *= (kMaxSamples - 1.0) / kMaxSamples;
+  }
+  estimate_ = mean_ + std::sqrt(m2_ / (count_ - 1.0));
+}
+
+}  // namespace karma::app
@@ -0,0 +1,221 @@
+#include "karma/app/input_recording.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace karma::app {
+namespace {
+
+constexpr uint32_t kMagic = 0x4345524b;  // "KREC"
+constexpr uint32_t kVersion = 1;
+
+static_assert(static_cast<int>(platform::Key::World2) < 256, "Key no longer fits in one byte.");
+
+class Writer {
+ public:
+  template <typename T>
+  void write(T value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const size_t offset = bytes_.size();
+    bytes_.resize(offset + sizeof(T));
+    std::memcpy(bytes_.data() + offset, &value, sizeof(T));
+  }
+
+  const std::string& bytes() const { return bytes_; }
+
+ private:
+  std::string bytes_;
+};
+
+class Reader {
+ public:
+  explicit Reader(const std::string& bytes) : bytes_(bytes) {}
+
+  template <typename T>
+  T read() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (bytes_.size() - offset_ < sizeof(T)) {
+      throw std::runtime_error("Input recording: unexpected end of data.");
+    }
+    T value;
+    std::memcpy(&value, bytes_.data() + offset_, sizeof(T));
+    offset_ += sizeof(T);
+    return value;
+  }
+
+  size_t remaining() const { return bytes_.size() - offset_; }
+
+ private:
+  const std::string& bytes_;
+  size_t offset_ = 0;
+};
+
+uint8_t packModifiers(const platform::Modifiers& mods) {
+  return static_cast<uint8_t>((mods.shift ? 1 : 0) | (mods.control ? 2 : 0) | (mods.alt ? 4 : 0) |
+                              (mods.super ? 8 : 0));
+}
+
+platform::Modifiers unpackModifiers(uint8_t bits) {
+  return {(bits & 1) != 0, (bits & 2) != 0, (bits & 4) != 0, (bits & 8) != 0};
+}
+
+void writeEvent(Writer& out, const platform::Event& event) {
+  out.write(static_cast<uint8_t>(event.type));
+  switch (event.type) {
+    case platform::EventType::KeyDown:
+    case platform::EventType::KeyUp:
+      out.write(static_cast<uint8_t>(event.key));
+      out.write(packModifiers(event.mods));
+      break;
+    case platform::EventType::TextInput:
+      out.write(event.codepoint);
+      break;
+    case platform::EventType::MouseButtonDown:
+    case platform::EventType::MouseButtonUp:
+      out.write(static_cast<uint8_t>(event.mouseButton));
+      out.write(packModifiers(event.mods));
+      break;
+    case platform::EventType::MouseMove:
+      out.write(event.x);
+      out.write(event.y);
+      break;
+    case platform::EventType::MouseScroll:
+      out.write(event.scrollX);
+      out.write(event.scrollY);
+      break;
+    case platform::EventType::WindowResize:
+      out.write(static_cast<int32_t>(event.width));
+      out.write(static_cast<int32_t>(event.height));
+      break;
+    case platform::EventType::WindowFocus:
+      out.write(static_cast<uint8_t>(event.focused));
+      break;
+    case platform::EventType::WindowClose:
+      break;
+  }
+}
+
+platform::Event readEvent(Reader& in) {
+  platform::Event event;
+  const auto type = in.read<uint8_t>();
+  if (type > static_cast<uint8_t>(platform::EventType::WindowClose)) {
+    throw std::runtime_error("Input recording: unknown event type.");
+  }
+  event.type = static_cast<platform::EventType>(type);
+  switch (event.type) {
+    case platform::EventType::KeyDown:
+    case platform::EventType::KeyUp: {
+      const auto key = in.read<uint8_t>();
+      if (key > static_cast<uint8_t>(platform::Key::World2)) {
+        throw std::runtime_error("Input recording: unknown key.");
+      }
+      event.key = static_cast<platform::Key>(key);
+      event.mods = unpackModifiers(in.read<uint8_t>());
+      break;
+    }
+    case platform::EventType::TextInput:
+      event.codepoint = in.read<uint32_t>();
+      break;
+    case platform::EventType::MouseButtonDown:
+    case platform::EventType::MouseButtonUp: {
+      const auto button = in.read<uint8_t>();
+      if (button > static_cast<uint8_t>(platform::MouseButton::Button8)) {
+        throw std::runtime_error("Input recording: unknown mouse button.");
+      }
+      event.mouseButton = static_cast<platform::MouseButton>(button);
+      event.mods = unpackModifiers(in.read<uint8_t>());
+      break;
+    }
+    case platform::EventType::MouseMove:
+      event.x = in.read<double>();
+      event.y = in.read<double>();
+      break;
+    case platform::EventType::MouseScroll:
+      event.scrollX = in.read<double>();
+      event.scrollY = in.read<double>();
+      break;
+    case platform::EventType::WindowResize:
+      event.width = in.read<int32_t>();
+      event.height = in.read<int32_t>();
+      break;
+    case platform::EventType::WindowFocus:
+      event.focused = in.read<uint8_t>() != 0;
+      break;
+    case platform::EventType::WindowClose:
+      break;
+  }
+  return event;
+}
+
+}  // namespace
+
+void saveInputRecording(const InputRecording& recording, const std::filesystem::path& path) {
+  Writer out;
+  out.write(kMagic);
+  out.write(kVersion);
+  out.write(recording.seed);
+  out.write(recording.fixed_dt);
+  out.write(static_cast<uint64_t>(recording.frames.size()));
+  for (const RecordedFrame& frame : recording.frames) {
+    out.write(frame.dt);
+    out.write(static_cast<uint32_t>(frame.events.size()));
+    for (const platform::Event& event : frame.events) {
+      writeEvent(out, event);
+    }
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Input recording: cannot create " + path.string());
+  }
+  file.write(out.bytes().data(), static_cast<std::streamsize>(out.bytes().size()));
+  if (!file) {
+    throw std::runtime_error("Input recording: failed writing " + path.string());
+  }
+}
+
+InputRecording loadInputRecording(const std::filesystem::path& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    throw std::runtime_error("Input recording: cannot open " + path.string());
+  }
+  const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  Reader in(bytes);
+  if (in.read<uint32_t>() != kMagic) {
+    throw std::runtime_error("Input recording: " + path.string() + " is not a recording.");
+  }
+  if (in.read<uint32_t>() != kVersion) {
+    throw std::runtime_error("Input recording: unsupported version.");
+  }
+  InputRecording recording;
+  recording.seed = in.read<uint64_t>();
+  recording.fixed_dt = in.read<float>();
+  if (!(recording.fixed_dt > 0.0f)) {
+    throw std::runtime_error("Input recording: invalid fixed_dt.");
+  }
+  const auto frame_count = in.read<uint64_t>();
+  // Every frame takes at least its dt and event count.
+  if (frame_count > in.remaining() / (sizeof(float) + sizeof(uint32_t))) {
+    throw std::runtime_error("Input recording: unexpected end of data.");
+  }
+  recording.frames.resize(static_cast<size_t>(frame_count));
+  for (RecordedFrame& frame : recording.frames) {
+    frame.dt = in.read<float>();
+    const auto event_count = in.read<uint32_t>();
+    if (event_count > in.remaining()) {
+      throw std::runtime_error("Input recording: unexpected end of data.");
+    }
+    frame.events.reserve(event_count);
+    for (uint32_t i = 0; i < event_count; ++i) {
+      frame.events.push_back(readEvent(in));
+    }
+  }
+  return recording;
+}
+
+}  // namespace karma::app
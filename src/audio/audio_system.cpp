@@ -1,6 +1,7 @@
 #include "karma/audio/audio_system.h"
 
 #include <exception>
+#include <utility>
 
 #include <glm/gtc/quaternion.hpp>
 #include <spdlog/spdlog.h>
@@ -20,12 +21,13 @@ AudioClip& AudioSystem::getClip(const std::string& key, int max_instances) {
 }
 
 void AudioSystem::update(ecs::World& world, float /*dt*/) {
+  bind(world);
   ecs::Entity listener_entity{};
   bool has_listener = false;
   bool multiple_listeners = false;
 
   for (const ecs::Entity entity :
-       world.view<components::AudioListenerComponent, components::TransformComponent>()) {
+       world.view<const components::AudioListenerComponent, const components::TransformComponent>()) {
     if (!has_listener) {
       listener_entity = entity;
       has_listener = true;
@@ -43,49 +45,50 @@ void AudioSystem::update(ecs::World& world, float /*dt*/) {
     warned_multiple_listeners_ = false;
   }
 
+  // Listeners and sources may hang off scene nodes, so they use the world pose.
+  const auto& matrices = std::as_const(world).storage<components::WorldMatrixComponent>();
   if (has_listener) {
-    const auto& transform = world.get<components::TransformComponent>(listener_entity);
-    const math::Vec3 pos = transform.position();
-    const math::Quat rot = transform.rotation();
+    const auto& transform = std::as_const(world).get<components::TransformComponent>(listener_entity);
+    const components::WorldPose pose = components::worldPose(matrices, listener_entity, transform);
+    const math::Vec3 pos = pose.position;
+    const math::Quat rot = pose.rotation;
     audio_.setListenerPosition({pos.x, pos.y, pos.z});
     audio_.setListenerRotation({rot.w, rot.x, rot.y, rot.z});
     warned_no_listener_ = false;
   }
 
   bool played_without_listener = false;
-  for (const ecs::Entity entity :
-       world.view<components::AudioSourceComponent, components::TransformComponent>()) {
-    const uint64_t key = entityKey(entity);
-    auto& source = world.get<components::AudioSourceComponent>(entity);
-    const bool should_play_on_start = source.play_on_start && !played_on_start_[key];
-    const bool should_play_requested = source.consumePlayRequest();
-    if (!should_play_on_start && !should_play_requested) {
-      continue;
-    }
-
-    const auto& transform = world.get<components::TransformComponent>(entity);
-    try {
-      const int max_instances = source.max_instances > 0 ? source.max_instances : 1;
-      auto& clip = getClip(source.clip_key, max_instances);
-      const math::Vec3 pos = transform.position();
-      clip.setSpatialDefaults(source.spatialized, source.min_distance, source.max_distance);
-      if (source.spatialized) {
-        clip.playSpatial({pos.x, pos.y, pos.z},
-                         source.gain,
-                         source.min_distance,
-                         source.max_distance);
-      } else {
-        clip.play({pos.x, pos.y, pos.z},
-                  source.gain);
+  // play_on_start fires once per component; sources still missing a Transform
+  // stay queued until they get one.
+  if (!pending_start_.empty()) {
+    const auto& sources = std::as_const(world).storage<components::AudioSourceComponent>();
+    const auto& transforms = std::as_const(world).storage<components::TransformComponent>();
+    size_t kept = 0;
+    for (const ecs::Entity entity : pending_start_) {
+      pending_slot_[entity.index] = kNoSlot;
+      if (!world.isAlive(entity) || !sources.has(entity)) {
+        continue;
       }
-      if (should_play_on_start) {
-        played_on_start_[key] = true;
+      if (!transforms.has(entity)) {
+        pending_slot_[entity.index] = static_cast<uint32_t>(kept);
+        pending_start_[kept++] = entity;
+        continue;
       }
-      if (!has_listener) {
+      const math::Vec3 pos = components::worldPose(matrices, entity, transforms.get(entity)).position;
+      if (playSource(sources.get(entity), pos) && !has_listener) {
         played_without_listener = true;
       }
-    } catch (const std::exception& ex) {
-      spdlog::error("Karma: Failed to play audio '{}': {}", source.clip_key, ex.what());
+    }
+    pending_start_.resize(kept);
+  }
+
+  for (auto [entity, source, transform] :
+       world.view<components::AudioSourceComponent, const components::TransformComponent>().each()) {
+    if (!source.consumePlayRequest()) {
+      continue;
+    }
+    if (playSource(source, components::worldPose(matrices, entity, transform).position) && !has_listener) {
+      played_without_listener = true;
     }
   }
 
@@ -93,17 +96,80 @@ void AudioSystem::update(ecs::World& world, float /*dt*/) {
     spdlog::warn("Karma: Audio played without an AudioListenerComponent in the scene.");
     warned_no_listener_ = true;
   }
+}
+
+void AudioSystem::bind(ecs::World& world) {
+  if (bound_world_ == &world && connections_.front().connected()) {
+    return;
+  }
+  connections_.clear();
+  bound_world_ = &world;
+  connections_.push_back(world.onConstruct<components::AudioSourceComponent>().connect(
+      [this](ecs::Entity entity, const components::AudioSourceComponent& source) {
+        if (source.play_on_start) {
+          queueStart(entity);
+        }
+      }));
+  connections_.push_back(world.onDestroy<components::AudioSourceComponent>().connect(
+      [this](ecs::Entity entity, const components::AudioSourceComponent&) { dequeueStart(entity); }));
 
-  if (!played_on_start_.empty()) {
-    for (auto it = played_on_start_.begin(); it != played_on_start_.end();) {
-      const ecs::Entity entity{static_cast<uint32_t>(it->first >> 32),
-                               static_cast<uint32_t>(it->first & 0xFFFFFFFFu)};
-      if (!world.isAlive(entity)) {
-        it = played_on_start_.erase(it);
-      } else {
-        ++it;
-      }
+  pending_start_.clear();
+  pending_slot_.clear();
+  for (auto [entity, source] : std::as_const(world).view<components::AudioSourceComponent>().each()) {
+    if (source.play_on_start) {
+      queueStart(entity);
+    }
+  }
+}
+
+void AudioSystem::queueStart(ecs::Entity entity) {
+  if (entity.index >= pending_slot_.size()) {
+    pending_slot_.resize(entity.index + 1, kNoSlot);
+  }
+  const uint32_t slot = pending_slot_[entity.index];
+  if (slot != kNoSlot) {
+    // A stale entry for a destroyed entity with the same index is replaced.
+    pending_start_[slot] = entity;
+    return;
+  }
+  pending_slot_[entity.index] = static_cast<uint32_t>(pending_start_.size());
+  pending_start_.push_back(entity);
+}
+
+// Swap-removes, so destroying many pending sources stays linear overall.
+void AudioSystem::dequeueStart(ecs::Entity entity) {
+  if (entity.index >= pending_slot_.size()) {
+    return;
+  }
+  const uint32_t slot = pending_slot_[entity.index];
+  if (slot == kNoSlot || pending_start_[slot] != entity) {
+    return;
+  }
+  const ecs::Entity last = pending_start_.back();
+  pending_start_[slot] = last;
+  pending_slot_[last.index] = slot;
+  pending_start_.pop_back();
+  pending_slot_[entity.index] = kNoSlot;
+}
+
+bool AudioSystem::playSource(const components::AudioSourceComponent& source, const math::Vec3& pos) {
+  try {
+    const int max_instances = source.max_instances > 0 ? source.max_instances : 1;
+    auto& clip = getClip(source.clip_key, max_instances);
+    clip.setSpatialDefaults(source.spatialized, source.min_distance, source.max_distance);
+    if (source.spatialized) {
+      clip.playSpatial({pos.x, pos.y, pos.z},
+                       source.gain,
+                       source.min_distance,
+                       source.max_distance);
+    } else {
+      clip.play({pos.x, pos.y, pos.z},
+                source.gain);
     }
+    return true;
+  } catch (const std::exception& ex) {
+    spdlog::error("Karma: Failed to play audio '{}': {}", source.clip_key, ex.what());
+    return false;
   }
 }
 
@@ -0,0 +1,119 @@
+#include "karma/core/frame_arena.h"
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+namespace karma::core {
+namespace {
+
+struct ThreadArena {
+  FrameArena arena;
+  uint64_t frame = 0;
+};
+
+struct Registry {
+  std::mutex mutex;
+  // Arenas outlive their threads so their high-water marks still report.
+  std::vector<std::unique_ptr<ThreadArena>> arenas;
+  std::atomic<uint64_t> frame{0};
+};
+
+Registry& registry() {
+  static Registry instance;
+  return instance;
+}
+
+thread_local ThreadArena* t_arena = nullptr;
+
+std::byte* alignUp(std::byte* ptr, size_t alignment) {
+  const auto address = reinterpret_cast<uintptr_t>(ptr);
+  return ptr + ((alignment - address % alignment) % alignment);
+}
+
+}  // namespace
+
+FrameArena::FrameArena(size_t capacity)
+    : block_(std::make_unique_for_overwrite<std::byte[]>(std::max<size_t>(capacity, 1))),
+      capacity_(std::max<size_t>(capacity, 1)) {}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+  std::byte* const base = block_.get() + offset_;
+  std::byte* const aligned = alignUp(base, alignment);
+  const size_t padded = static_cast<size_t>(aligned - base) + size;
+  std::byte* result = nullptr;
+  if (padded <= capacity_.load(std::memory_order_relaxed) - offset_) {
+    offset_ += padded;
+    result = aligned;
+  } else {
+    const size_t bytes = size + alignment;
+    overflow_.push_back(std::make_unique_for_overwrite<std::byte[]>(bytes));
+    overflow_count_.fetch_add(1, std::memory_order_relaxed);
+    overflow_bytes_ += bytes;
+    result = alignUp(overflow_.back().get(), alignment);
+  }
+  if (used() > high_water_.load(std::memory_order_relaxed)) {
+    high_water_.store(used(), std::memory_order_relaxed);
+  }
+  return result;
+}
+
+// Only the top of the block can be taken back; anything else waits for
+// reset(). Scoped temporaries that are freed in reverse order, the common case,
+// therefore cost nothing even when no one resets the arena.
+void FrameArena::deallocate(void* ptr, size_t size) noexcept {
+  std::byte* const bytes = static_cast<std::byte*>(ptr);
+  if (bytes + size == block_.get() + offset_) {
+    offset_ = static_cast<size_t>(bytes - block_.get());
+  }
+}
+
+void FrameArena::reset() {
+  if (!overflow_.empty()) {
+    size_t capacity = capacity_.load(std::memory_order_relaxed);
+    while (capacity < used()) {
+      capacity *= 2;
+    }
+    overflow_.clear();
+    overflow_bytes_ = 0;
+    block_.reset();
+    block_ = std::make_unique_for_overwrite<std::byte[]>(capacity);
+    capacity_.store(capacity, std::memory_order_relaxed);
+  }
+  offset_ = 0;
+}
+
+FrameArena& frameArena() {
+  Registry& reg = registry();
+  if (!t_arena) {
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto arena = std::make_unique<ThreadArena>();
+    t_arena = arena.get();
+    reg.arenas.push_back(std::move(arena));
+  }
+  const uint64_t frame = reg.frame.load(std::memory_order_relaxed);
+  if (t_arena->frame != frame) {
+    t_arena->arena.reset();
+    t_arena->frame = frame;
+  }
+  return t_arena->arena;
+}
+
+void resetFrameArenas() {
+  registry().frame.fetch_add(1, std::memory_order_relaxed);
+}
+
+FrameArenaStats frameArenaStats() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  FrameArenaStats stats;
+  stats.threads = reg.arenas.size();
+  for (const auto& entry : reg.arenas) {
+    stats.capacity_bytes += entry->arena.capacity();
+    stats.high_water_bytes += entry->arena.highWater();
+    stats.overflow_count += entry->arena.overflowCount();
+  }
+  return stats;
+}
+
+}  // namespace karma::core
@@ -0,0 +1,131 @@
+#include "karma/ecs/command_buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <utility>
+
+#include "karma/ecs/world.h"
+
+namespace karma::ecs {
+
+CommandBuffer::CommandBuffer(CommandBuffer&& other) noexcept
+    : commands_(std::move(other.commands_)),
+      destroyed_(std::move(other.destroyed_)),
+      created_(std::move(other.created_)),
+      reserves_(std::move(other.reserves_)),
+      blocks_(std::move(other.blocks_)),
+      block_index_(std::exchange(other.block_index_, 0)),
+      block_offset_(std::exchange(other.block_offset_, 0)),
+      pending_count_(std::exchange(other.pending_count_, 0)),
+      tag_(std::exchange(other.tag_, nextTag())) {
+  other.commands_.clear();
+  other.destroyed_.clear();
+}
+
+CommandBuffer& CommandBuffer::operator=(CommandBuffer&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  // Destroys the payloads this buffer still holds before its blocks go away.
+  clear();
+  commands_ = std::move(other.commands_);
+  destroyed_ = std::move(other.destroyed_);
+  created_ = std::move(other.created_);
+  reserves_ = std::move(other.reserves_);
+  blocks_ = std::move(other.blocks_);
+  block_index_ = std::exchange(other.block_index_, 0);
+  block_offset_ = std::exchange(other.block_offset_, 0);
+  pending_count_ = std::exchange(other.pending_count_, 0);
+  tag_ = std::exchange(other.tag_, nextTag());
+  other.commands_.clear();
+  other.destroyed_.clear();
+  return *this;
+}
+
+void CommandBuffer::playback(World& world) {
+  created_.clear();
+  created_.reserve(pending_count_);
+  for (uint32_t i = 0; i < pending_count_; ++i) {
+    created_.push_back(world.createEntity());
+  }
+
+  reserves_.clear();
+  for (const Command& command : commands_) {
+    if (!command.reserve) {
+      continue;
+    }
+    auto it = std::find_if(reserves_.begin(), reserves_.end(),
+                           [&](const auto& entry) { return entry.first == command.reserve; });
+    if (it == reserves_.end()) {
+      reserves_.emplace_back(command.reserve, 1);
+    } else {
+      ++it->second;
+    }
+  }
+  for (const auto& [reserve, count] : reserves_) {
+    reserve(world, count);
+  }
+
+  for (const Command& command : commands_) {
+    command.apply(world, resolve(command.entity), command.payload);
+  }
+
+  for (Entity& entity : destroyed_) {
+    entity = resolve(entity);
+  }
+  world.destroyEntities(destroyed_);
+
+  clear();
+}
+
+void CommandBuffer::clear() {
+  for (const Command& command : commands_) {
+    if (command.destroy) {
+      command.destroy(command.payload);
+    }
+  }
+  commands_.clear();
+  destroyed_.clear();
+  block_index_ = 0;
+  block_offset_ = 0;
+  pending_count_ = 0;
+  // Placeholders from this batch must not resolve against the next one.
+  tag_ = nextTag();
+}
+
+void* CommandBuffer::allocate(size_t size, size_t alignment) {
+  while (block_index_ < blocks_.size()) {
+    Block& block = blocks_[block_index_];
+    const size_t offset = (block_offset_ + alignment - 1) & ~(alignment - 1);
+    if (offset + size <= block.size) {
+      block_offset_ = offset + size;
+      return block.data.get() + offset;
+    }
+    ++block_index_;
+    block_offset_ = 0;
+  }
+  const size_t block_size = std::max(kBlockSize, size);
+  blocks_.push_back(Block{std::make_unique_for_overwrite<std::byte[]>(block_size), block_size});
+  block_offset_ = size;
+  return blocks_.back().data.get();
+}
+
+uint32_t CommandBuffer::nextTag() {
+  static std::atomic<uint32_t> counter{0};
+  return kPendingMask | (counter.fetch_add(1, std::memory_order_relaxed) & ~kPendingMask);
+}
+
+void CommandBuffer::throwForeign() {
+  throw std::logic_error(
+      "CommandBuffer: placeholder entity was created by another buffer or an earlier batch.");
+}
+
+Entity CommandBuffer::resolve(Entity entity) const {
+  if (entity.generation == tag_ && entity.index < created_.size()) {
+    return created_[entity.index];
+  }
+  return entity;
+}
+
+}  // namespace karma::ecs
@@ -0,0 +1,387 @@
+#include "karma/ecs/snapshot.h"
+
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "karma/components/audio_listener.h"
+#include "karma/components/audio_source.h"
+#include "karma/components/camera.h"
+#include "karma/components/collider.h"
+#include "karma/components/environment.h"
+#include "karma/components/light.h"
+#include "karma/components/mesh.h"
+#include "karma/components/player_controller.h"
+#include "karma/components/rigidbody.h"
+#include "karma/components/script.h"
+#include "karma/components/tag.h"
+#include "karma/components/transform.h"
+#include "karma/components/visibility.h"
+
+namespace karma::ecs {
+
+namespace {
+
+constexpr uint32_t kSnapshotMagic = 0x504E534Bu;  // "KSNP"
+constexpr uint32_t kSnapshotVersion = 1;
+
+// Read-only view of a snapshot file. POSIX builds map it; elsewhere the file is
+// read into memory.
+class SnapshotFile {
+ public:
+  explicit SnapshotFile(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+      throw std::runtime_error("Snapshot: cannot open " + path.string());
+    }
+    buffer_.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()));
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#else
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      throw std::runtime_error("Snapshot: cannot open " + path.string());
+    }
+    struct stat info{};
+    if (::fstat(fd_, &info) != 0) {
+      ::close(fd_);
+      throw std::runtime_error("Snapshot: cannot stat " + path.string());
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0) {
+      void* mapping = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (mapping == MAP_FAILED) {
+        ::close(fd_);
+        throw std::runtime_error("Snapshot: cannot map " + path.string());
+      }
+      ::madvise(mapping, size_, MADV_SEQUENTIAL);
+      data_ = static_cast<const std::byte*>(mapping);
+    }
+#endif
+  }
+
+  ~SnapshotFile() {
+#if !defined(_WIN32)
+    if (data_) {
+      ::munmap(const_cast<std::byte*>(data_), size_);
+    }
+    ::close(fd_);
+#endif
+  }
+
+  SnapshotFile(const SnapshotFile&) = delete;
+  SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+  const std::byte* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  const std::byte* data_ = nullptr;
+  size_t size_ = 0;
+#if defined(_WIN32)
+  std::vector<std::byte> buffer_;
+#else
+  int fd_ = -1;
+#endif
+};
+
+template <typename T>
+void writeVector(SnapshotWriter& out, const std::vector<T>& values) {
+  out.write<uint64_t>(values.size());
+  out.writeBytes(values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+std::vector<T> readVector(SnapshotReader& in) {
+  const auto count = static_cast<size_t>(in.read<uint64_t>());
+  const std::byte* bytes = in.readArray(count, sizeof(T));
+  std::vector<T> values(count);
+  std::memcpy(values.data(), bytes, count * sizeof(T));
+  return values;
+}
+
+void validateFreeList(const EntityRegistry& entities) {
+  const size_t count = entities.generations().size();
+  std::vector<uint8_t> seen(count, 0);
+  for (const uint32_t index : entities.freeList()) {
+    if (index >= count || seen[index] != 0) {
+      throw std::runtime_error("Snapshot: corrupt entity free list.");
+    }
+    seen[index] = 1;
+  }
+}
+
+}  // namespace
+
+void SnapshotRegistry::validateDense(std::span<const Entity> dense, const EntityRegistry& entities) {
+  const std::vector<uint32_t>& generations = entities.generations();
+  enum : uint8_t { kFree = 1, kUsed = 2 };
+  std::vector<uint8_t> marks(generations.size(), 0);
+  for (const uint32_t index : entities.freeList()) {
+    marks[index] = kFree;
+  }
+  for (const Entity entity : dense) {
+    if (entity.index >= generations.size() || generations[entity.index] != entity.generation ||
+        marks[entity.index] != 0) {
+      throw std::runtime_error("Snapshot: component owned by a dead or repeated entity.");
+    }
+    marks[entity.index] = kUsed;
+  }
+}
+
+void SnapshotWriter::writeBytes(const void* data, size_t size) {
+  const auto* bytes = static_cast<const std::byte*>(data);
+  bytes_.insert(bytes_.end(), bytes, bytes + size);
+}
+
+void SnapshotWriter::writeString(std::string_view value) {
+  write<uint32_t>(static_cast<uint32_t>(value.size()));
+  writeBytes(value.data(), value.size());
+}
+
+void SnapshotWriter::align(size_t alignment) {
+  bytes_.resize((bytes_.size() + alignment - 1) / alignment * alignment, std::byte{0});
+}
+
+const std::byte* SnapshotReader::readBytes(size_t size) {
+  if (size > size_ - offset_) {
+    throw std::runtime_error("Snapshot: unexpected end of data.");
+  }
+  const std::byte* bytes = data_ + offset_;
+  offset_ += size;
+  return bytes;
+}
+
+const std::byte* SnapshotReader::readArray(size_t count, size_t element_size) {
+  if (element_size != 0 && count > (size_ - offset_) / element_size) {
+    throw std::runtime_error("Snapshot: unexpected end of data.");
+  }
+  return readBytes(count * element_size);
+}
+
+std::string SnapshotReader::readString() {
+  const uint32_t length = read<uint32_t>();
+  const std::byte* bytes = readBytes(length);
+  return std::string(reinterpret_cast<const char*>(bytes), length);
+}
+
+void SnapshotReader::align(size_t alignment) {
+  const size_t aligned = (offset_ + alignment - 1) / alignment * alignment;
+  readBytes(aligned - offset_);
+}
+
+SnapshotRegistry SnapshotRegistry::engineDefaults() {
+  using namespace components;
+  SnapshotRegistry registry;
+  registry.add<TransformComponent>("karma.transform");
+  registry.add<RigidbodyComponent>("karma.rigidbody");
+  registry.add<ColliderComponent>("karma.collider");
+  registry.add<VisibilityComponent>("karma.visibility");
+  registry.add<LightComponent>("karma.light");
+  registry.add<PlayerControllerComponent>("karma.player_controller");
+  registry.add<AudioListenerComponent>("karma.audio_listener");
+  registry.add<MeshComponent>(
+      "karma.mesh",
+      [](const MeshComponent& mesh, SnapshotWriter& out) {
+        out.writeString(mesh.mesh_key);
+        out.writeString(mesh.material_key);
+        out.writeString(mesh.texture_key);
+        out.write<uint8_t>(mesh.visible);
+      },
+      [](SnapshotReader& in) {
+        MeshComponent mesh;
+        mesh.mesh_key = in.readString();
+        mesh.material_key = in.readString();
+        mesh.texture_key = in.readString();
+        mesh.visible = in.read<uint8_t>() != 0;
+        return mesh;
+      });
+  registry.add<TagComponent>(
+      "karma.tag",
+      [](const TagComponent& tag, SnapshotWriter& out) { out.writeString(tag.name); },
+      [](SnapshotReader& in) {
+        TagComponent tag;
+        tag.name = in.readString();
+        return tag;
+      });
+  registry.add<CameraComponent>(
+      "karma.camera",
+      [](const CameraComponent& camera, SnapshotWriter& out) {
+        out.write(camera.fov_y_degrees);
+        out.write(camera.near_clip);
+        out.write(camera.far_clip);
+        out.write<uint8_t>(camera.is_primary);
+        out.write<uint8_t>(camera.render_to_texture);
+        out.writeString(camera.render_target_key);
+      },
+      [](SnapshotReader& in) {
+        CameraComponent camera;
+        camera.fov_y_degrees = in.read<float>();
+        camera.near_clip = in.read<float>();
+        camera.far_clip = in.read<float>();
+        camera.is_primary = in.read<uint8_t>() != 0;
+        camera.render_to_texture = in.read<uint8_t>() != 0;
+        camera.render_target_key = in.readString();
+        return camera;
+      });
+  registry.add<EnvironmentComponent>(
+      "karma.environment",
+      [](const EnvironmentComponent& env, SnapshotWriter& out) {
+        out.writeString(env.environment_map);
+        out.write(env.intensity);
+        out.write<uint8_t>(env.draw_skybox);
+        out.write<uint8_t>(env.enabled);
+      },
+      [](SnapshotReader& in) {
+        EnvironmentComponent env;
+        env.environment_map = in.readString();
+        env.intensity = in.read<float>();
+        env.draw_skybox = in.read<uint8_t>() != 0;
+        env.enabled = in.read<uint8_t>() != 0;
+        return env;
+      });
+  registry.add<ScriptComponent>(
+      "karma.script",
+      [](const ScriptComponent& script, SnapshotWriter& out) {
+        out.writeString(script.script_key);
+        out.write<uint8_t>(script.enabled);
+      },
+      [](SnapshotReader& in) {
+        ScriptComponent script;
+        script.script_key = in.readString();
+        script.enabled = in.read<uint8_t>() != 0;
+        return script;
+      });
+  // Pending play requests are transient and not saved.
+  registry.add<AudioSourceComponent>(
+      "karma.audio_source",
+      [](const AudioSourceComponent& source, SnapshotWriter& out) {
+        out.writeString(source.clip_key);
+        out.write(source.gain);
+        out.write(source.pitch);
+        out.write(source.min_distance);
+        out.write(source.max_distance);
+        out.write<uint8_t>(source.looping);
+        out.write<uint8_t>(source.play_on_start);
+        out.write<uint8_t>(source.spatialized);
+        out.write(source.max_instances);
+      },
+      [](SnapshotReader& in) {
+        AudioSourceComponent source;
+        source.clip_key = in.readString();
+        source.gain = in.read<float>();
+        source.pitch = in.read<float>();
+        source.min_distance = in.read<float>();
+        source.max_distance = in.read<float>();
+        source.looping = in.read<uint8_t>() != 0;
+        source.play_on_start = in.read<uint8_t>() != 0;
+        source.spatialized = in.read<uint8_t>() != 0;
+        source.max_instances = in.read<int>();
+        return source;
+      });
+  return registry;
+}
+
+void saveSnapshot(const World& world, const SnapshotRegistry& registry, SnapshotWriter& out) {
+  if (world.storageMode() != StorageMode::SparseSet) {
+    throw std::logic_error("Snapshot: only sparse-set worlds can be saved.");
+  }
+  out.write(kSnapshotMagic);
+  out.write(kSnapshotVersion);
+  writeVector(out, world.registry().generations());
+  writeVector(out, world.registry().freeList());
+  out.write<uint32_t>(static_cast<uint32_t>(registry.entries_.size()));
+  for (const auto& entry : registry.entries_) {
+    out.writeString(entry.name);
+    out.write(entry.element_size);
+    const size_t length_offset = out.size();
+    out.write<uint64_t>(0);
+    const size_t begin = out.size();
+    entry.save(world, out);
+    out.patch<uint64_t>(length_offset, out.size() - begin);
+  }
+}
+
+void loadSnapshot(World& world, const SnapshotRegistry& registry, SnapshotReader& in) {
+  if (world.storageMode() != StorageMode::SparseSet) {
+    throw std::logic_error("Snapshot: only sparse-set worlds can be loaded.");
+  }
+  if (in.read<uint32_t>() != kSnapshotMagic) {
+    throw std::runtime_error("Snapshot: not a snapshot image.");
+  }
+  if (in.read<uint32_t>() != kSnapshotVersion) {
+    throw std::runtime_error("Snapshot: unsupported version.");
+  }
+  auto generations = readVector<uint32_t>(in);
+  auto free_list = readVector<uint32_t>(in);
+  EntityRegistry entities;
+  entities.restore(std::move(generations), std::move(free_list));
+  validateFreeList(entities);
+
+  // Every section is parsed and validated before the world is touched, so a
+  // bad image throws with the world unchanged.
+  std::vector<SnapshotRegistry::Commit> commits;
+  const uint32_t section_count = in.read<uint32_t>();
+  for (uint32_t i = 0; i < section_count; ++i) {
+    const std::string name = in.readString();
+    const uint32_t element_size = in.read<uint32_t>();
+    const auto length = static_cast<size_t>(in.read<uint64_t>());
+    const size_t begin = in.offset();
+    const SnapshotRegistry::Entry* match = nullptr;
+    for (const auto& entry : registry.entries_) {
+      if (entry.name == name) {
+        match = &entry;
+        break;
+      }
+    }
+    if (!match) {
+      in.skip(length);
+      continue;
+    }
+    if (match->element_size != element_size) {
+      throw std::runtime_error("Snapshot: layout of '" + name + "' does not match this build.");
+    }
+    commits.push_back(match->load(in, entities));
+    if (in.offset() - begin != length) {
+      throw std::runtime_error("Snapshot: section '" + name + "' has an unexpected length.");
+    }
+  }
+
+  world.restoreRegistry(std::move(entities));
+  for (const auto& commit : commits) {
+    commit(world);
+  }
+}
+
+void saveSnapshot(const World& world, const SnapshotRegistry& registry,
+                  const std::filesystem::path& path) {
+  SnapshotWriter out;
+  saveSnapshot(world, registry, out);
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Snapshot: cannot create " + path.string());
+  }
+  file.write(reinterpret_cast<const char*>(out.bytes().data()),
+             static_cast<std::streamsize>(out.size()));
+  if (!file) {
+    throw std::runtime_error("Snapshot: failed writing " + path.string());
+  }
+}
+
+void loadSnapshot(World& world, const SnapshotRegistry& registry, const std::filesystem::path& path) {
+  const SnapshotFile file(path);
+  SnapshotReader in(file.data(), file.size());
+  loadSnapshot(world, registry, in);
+}
+
+}  // namespace karma::ecs
@@ -1,18 +1,8 @@
 #include "karma/input/input_system.h"
 
-#include "karma/platform/window.h"
-
 namespace karma::input {
 
 namespace {
-bool isKeyDown(const platform::Window& window, platform::Key key) {
-  return window.isKeyDown(key);
-}
-
-bool isMouseDown(const platform::Window& window, platform::MouseButton button) {
-  return window.isMouseDown(button);
-}
-
 bool isKeyEvent(const platform::Event& event, platform::Key key, platform::EventType type) {
   return event.type == type && event.key == key;
 }
@@ -62,21 +52,8 @@ void InputSystem::update(const std::vector<platform::Event>& events) {
   mouse_delta_x_ = 0.0f;
   mouse_delta_y_ = 0.0f;
 
-  if (window_) {
-    for (const auto& [action, bindings] : bindings_) {
-      for (const auto& binding : bindings) {
-        if (binding.trigger == Trigger::Down) {
-          if (binding.use_key && isKeyDown(*window_, binding.key)) {
-            down_this_frame_.insert(action);
-          } else if (!binding.use_key && isMouseDown(*window_, binding.mouse)) {
-            down_this_frame_.insert(action);
-          }
-        }
-      }
-    }
-  }
-
   for (const auto& event : events) {
+    trackHeld(event);
     if (event.type == platform::EventType::MouseMove) {
       if (has_mouse_pos_) {
         mouse_delta_x_ += static_cast<float>(event.x - last_mouse_x_);
@@ -105,6 +82,46 @@ void InputSystem::update(const std::vector<platform::Event>& events) {
       }
     }
   }
+
+  // Held state comes from the key and button events seen so far rather than
+  // from polling the window, so a replayed capture sees the same Down actions
+  // as the live session that recorded it.
+  for (const auto& [action, bindings] : bindings_) {
+    for (const auto& binding : bindings) {
+      if (binding.trigger != Trigger::Down) {
+        continue;
+      }
+      if (binding.use_key ? held_keys_.count(binding.key) != 0
+                          : held_buttons_.count(binding.mouse) != 0) {
+        down_this_frame_.insert(action);
+      }
+    }
+  }
+}
+
+void InputSystem::trackHeld(const platform::Event& event) {
+  switch (event.type) {
+    case platform::EventType::KeyDown:
+      held_keys_.insert(event.key);
+      break;
+    case platform::EventType::KeyUp:
+      held_keys_.erase(event.key);
+      break;
+    case platform::EventType::MouseButtonDown:
+      held_buttons_.insert(event.mouseButton);
+      break;
+    case platform::EventType::MouseButtonUp:
+      held_buttons_.erase(event.mouseButton);
+      break;
+    case platform::EventType::WindowFocus:
+      if (!event.focused) {
+        held_keys_.clear();
+        held_buttons_.clear();
+      }
+      break;
+    default:
+      break;
+  }
 }
 
 bool InputSystem::actionDown(const std::string& action) const {
@@ -8,6 +8,8 @@
 #include <cstring>
 #include <mutex>
 
+#include "karma/profiling/profiler.h"
+
 namespace karma::net {
 namespace {
 
@@ -172,6 +174,7 @@ class EnetClientTransport final : public IClientTransport {
     if (!host_) {
       return;
     }
+    KARMA_PROFILE_ZONE("EnetClientTransport::poll");
 
     ENetEvent event;
     while (enet_host_service(host_, &event, 0) > 0) {
@@ -284,6 +287,7 @@ class EnetServerTransport final : public IServerTransport {
     if (!host_) {
       return;
     }
+    KARMA_PROFILE_ZONE("EnetServerTransport::poll");
 
     ENetEvent event;
     while (enet_host_service(host_, &event, 0) > 0) {
@@ -0,0 +1,73 @@
+#include "karma/physics/backends/jolt/job_system_jolt.hpp"
+
+#include <chrono>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+namespace karma::physics_backend {
+
+JobSystemJolt::JobSystemJolt(tasks::Scheduler& scheduler, JPH::uint maxJobs, JPH::uint maxBarriers)
+    : scheduler_(scheduler) {
+    JobSystemWithBarrier::Init(maxBarriers);
+    jobs_.Init(maxJobs, maxJobs);
+}
+
+JobSystemJolt::~JobSystemJolt() {
+    // Queued tasks point into jobs_.
+    scheduler_.wait(queued_);
+}
+
+int JobSystemJolt::GetMaxConcurrency() const {
+    return static_cast<int>(scheduler_.workerCount()) + 1;
+}
+
+JobSystemJolt::JobHandle JobSystemJolt::CreateJob(const char* inName,
+                                        JPH::ColorArg inColor,
+                                        const JobFunction& inJobFunction,
+                                        JPH::uint32 inNumDependencies) {
+    JPH::uint32 index;
+    for (;;) {
+        index = jobs_.ConstructObject(inName, inColor, this, inJobFunction, inNumDependencies);
+        if (index != JPH::FixedSizeFreeList<Job>::cInvalidObjectIndex) {
+            break;
+        }
+        if (!pool_exhausted_.exchange(true, std::memory_order_relaxed)) {
+            spdlog::warn("Karma: Jolt job pool exhausted; waiting for a free job.");
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    if (pool_exhausted_.load(std::memory_order_relaxed)) {
+        pool_exhausted_.store(false, std::memory_order_relaxed);
+    }
+    Job* job = &jobs_.Get(index);
+    // Take the handle before queueing: the job may complete immediately.
+    JobHandle handle(job);
+    if (inNumDependencies == 0) {
+        QueueJob(job);
+    }
+    return handle;
+}
+
+void JobSystemJolt::QueueJob(Job* inJob) {
+    inJob->AddRef();
+    scheduler_.submit(queued_, &JobSystemJolt::runJob, inJob);
+}
+
+void JobSystemJolt::QueueJobs(Job** inJobs, JPH::uint inNumJobs) {
+    for (JPH::uint i = 0; i < inNumJobs; ++i) {
+        QueueJob(inJobs[i]);
+    }
+}
+
+void JobSystemJolt::FreeJob(Job* inJob) {
+    jobs_.DestructObject(inJob);
+}
+
+// A barrier may already have executed the job; Execute is then a no-op.
+void JobSystemJolt::runJob(void* job) {
+    auto* jolt_job = static_cast<Job*>(job);
+    jolt_job->Execute();
+    jolt_job->Release();
+}
+
+} // namespace karma::physics_backend
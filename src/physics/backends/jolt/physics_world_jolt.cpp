@@ -1,9 +1,10 @@
 #include "karma/physics/backends/jolt/physics_world_jolt.hpp"
+#include "karma/physics/backends/jolt/job_system_jolt.hpp"
 #include "karma/physics/backends/jolt/player_controller_jolt.hpp"
 #include "karma/physics/backends/jolt/rigid_body_jolt.hpp"
 #include "karma/physics/backends/jolt/static_body_jolt.hpp"
+#include "karma/profiling/profiler.h"
 #include <Jolt/Core/Factory.h>
-#include <Jolt/Core/JobSystemThreadPool.h>
 #include <Jolt/Core/TempAllocator.h>
 #include <Jolt/Physics/Body/Body.h>
 #include <Jolt/Physics/Body/BodyCreationSettings.h>
@@ -20,7 +21,6 @@
 #include <cstdarg>
 #include <cstdio>
 #include <spdlog/spdlog.h>
-#include <thread>
 
 namespace {
 using namespace JPH;
@@ -111,7 +111,7 @@ PhysicsWorldJolt::PhysicsWorldJolt() {
     initJoltOnce();
 
     tempAllocator_ = std::make_unique<TempAllocatorImpl>(32u * 1024u * 1024u);
-    jobSystem_ = std::make_unique<JobSystemThreadPool>(JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers, std::thread::hardware_concurrency());
+    jobSystem_ = std::make_unique<JobSystemJolt>(karma::tasks::scheduler(), JPH::cMaxPhysicsJobs, JPH::cMaxPhysicsBarriers);
 
     static BPLayerInterfaceImpl broadPhaseLayers;
     static ObjectVsBroadPhaseLayerFilterImpl objectVsBroadphaseFilter;
@@ -137,6 +137,7 @@ PhysicsWorldJolt::~PhysicsWorldJolt() {
 
 void PhysicsWorldJolt::update(float deltaTime) {
     if (!physicsSystem_) return;
+    KARMA_PROFILE_ZONE("PhysicsWorldJolt::update");
     physicsSystem_->Update(deltaTime, 1, tempAllocator_.get(), jobSystem_.get());
 }
 
@@ -1,7 +1,14 @@
 #include "karma/physics/physics_system.h"
 
 #include "karma/components/mesh.h"
+#include "karma/components/previous_transform.h"
 #include "karma/components/visibility.h"
+#include "karma/components/world_matrix.h"
+
+#include <cmath>
+#include <utility>
+
+#include <spdlog/spdlog.h>
 
 namespace karma::physics {
 
@@ -23,11 +30,50 @@ bool isBoxCollider(const components::ColliderComponent& collider) {
   return collider.shape == components::ColliderComponent::Shape::Box;
 }
 
+void pushPose(RigidBody& rigid,
+              const components::WorldPose& pose,
+              const components::RigidbodyComponent& body) {
+  rigid.setPosition(toGlm(pose.position));
+  rigid.setRotation(toGlm(pose.rotation));
+  rigid.setVelocity(toGlm(body.velocity));
+  rigid.setAngularVelocity(toGlm(body.angular_velocity));
+}
+
 ecs::Entity entityFromKey(uint64_t key) {
   return {static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key & 0xFFFFFFFFu)};
 }
 
-bool collisionEnabled(ecs::World& world, ecs::Entity entity) {
+bool sameVec3(const math::Vec3& a, const math::Vec3& b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+bool sameQuat(const math::Quat& a, const math::Quat& b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w;
+}
+
+// Loose enough to absorb the round trip through the composed world matrix.
+bool nearPose(const components::WorldPose& pose, const components::TransformComponent& transform) {
+  constexpr float kEpsilon = 1e-4f;
+  const math::Vec3& p = transform.position();
+  const math::Quat& q = transform.rotation();
+  const float dot = pose.rotation.x * q.x + pose.rotation.y * q.y + pose.rotation.z * q.z +
+                    pose.rotation.w * q.w;
+  return std::abs(pose.position.x - p.x) <= kEpsilon &&
+         std::abs(pose.position.y - p.y) <= kEpsilon &&
+         std::abs(pose.position.z - p.z) <= kEpsilon && std::abs(dot) >= 1.0f - kEpsilon;
+}
+
+// Owned group for the physics join; keeps the three storages packed in the same
+// order so the per-tick sync loops walk them linearly.
+using BodyGroup = ecs::Group<components::TransformComponent, components::ColliderComponent,
+                             components::RigidbodyComponent>;
+
+BodyGroup& bodyGroup(ecs::World& world) {
+  return world.group<components::TransformComponent, components::ColliderComponent,
+                     components::RigidbodyComponent>();
+}
+
+bool collisionEnabled(const ecs::World& world, ecs::Entity entity) {
   if (!world.has<components::VisibilityComponent>(entity)) {
     return true;
   }
@@ -37,92 +83,223 @@ bool collisionEnabled(ecs::World& world, ecs::Entity entity) {
 }
 
 void PhysicsSystem::update(ecs::World& world, float dt) {
-  teleports_.clear();
-  syncRigidBodies(world);
+  bind(world);
+  TeleportList teleports;
+  releaseRemoved();
+  createPendingBodies(world);
+  syncRigidBodies(world, teleports);
   syncPlayerController(world, dt);
   physics_.update(dt);
   syncDynamicBodies(world);
-  applyTeleports(world);
-  cleanupStale(world);
+  applyTeleports(world, teleports);
+  last_tick_ = world.currentTick();
+  world.advanceTick();
 }
 
-void PhysicsSystem::syncRigidBodies(ecs::World& world) {
-  for (const ecs::Entity entity :
-       world.view<components::TransformComponent, components::ColliderComponent, components::RigidbodyComponent>()) {
-    if (!collisionEnabled(world, entity)) {
-      continue;
-    }
-    const auto& collider = world.get<components::ColliderComponent>(entity);
-    if (!isBoxCollider(collider)) {
-      continue;
-    }
+void PhysicsSystem::bind(ecs::World& world) {
+  if (bound_world_ == &world && connections_.front().connected()) {
+    return;
+  }
+  // Bodies mirrored from a previous world have nothing left to track them.
+  connections_.clear();
+  for (auto& [key, body] : rigid_bodies_) {
+    body.destroy();
+  }
+  rigid_bodies_.clear();
+  for (auto& [key, body] : static_bodies_) {
+    body.destroy();
+  }
+  static_bodies_.clear();
+  if (has_player_ && physics_.playerController()) {
+    physics_.playerController()->destroy();
+  }
+  has_player_ = false;
+  pending_.clear();
+  removed_rigid_.clear();
+  removed_static_.clear();
+  player_removed_ = false;
+  bound_world_ = &world;
 
-    const uint64_t key = entityKey(entity);
-    auto it = rigid_bodies_.find(key);
-    if (it == rigid_bodies_.end()) {
-      const auto& transform = world.get<components::TransformComponent>(entity);
-      const auto& body = world.get<components::RigidbodyComponent>(entity);
-      PhysicsMaterial material;
-      RigidBody rigid = physics_.createBoxBody(
-          toGlm(collider.half_extents),
-          body.mass,
-          toGlm(transform.position()),
-          material);
-      it = rigid_bodies_.emplace(key, std::move(rigid)).first;
-    }
+  const auto queue = [this](ecs::Entity entity, const auto&) { pending_.push_back(entity); };
+  connections_.push_back(world.onConstruct<components::TransformComponent>().connect(queue));
+  connections_.push_back(world.onConstruct<components::ColliderComponent>().connect(queue));
+  // A replaced Collider or Rigidbody (new shape, mass or kinematic flag) needs
+  // a new backend body: release the old one and queue the entity again.
+  const auto rebuild = [this](ecs::Entity entity, const auto&) {
+    removed_rigid_.push_back(entityKey(entity));
+    removed_static_.push_back(entityKey(entity));
+    pending_.push_back(entity);
+  };
+  connections_.push_back(world.onUpdate<components::ColliderComponent>().connect(rebuild));
+  connections_.push_back(world.onConstruct<components::RigidbodyComponent>().connect(queue));
+  connections_.push_back(world.onUpdate<components::RigidbodyComponent>().connect(rebuild));
+  connections_.push_back(world.onConstruct<components::MeshComponent>().connect(queue));
+  connections_.push_back(world.onConstruct<components::VisibilityComponent>().connect(queue));
+  connections_.push_back(world.onUpdate<components::VisibilityComponent>().connect(queue));
+  connections_.push_back(world.onDestroy<components::VisibilityComponent>().connect(queue));
+  // Losing the Rigidbody may leave a static mesh collider behind.
+  connections_.push_back(world.onDestroy<components::RigidbodyComponent>().connect(
+      [this](ecs::Entity entity, const components::RigidbodyComponent&) {
+        removed_rigid_.push_back(entityKey(entity));
+        pending_.push_back(entity);
+      }));
+  connections_.push_back(world.onDestroy<components::ColliderComponent>().connect(
+      [this](ecs::Entity entity, const components::ColliderComponent&) {
+        removed_static_.push_back(entityKey(entity));
+      }));
+  connections_.push_back(world.onDestroy<components::PlayerControllerComponent>().connect(
+      [this](ecs::Entity entity, const components::PlayerControllerComponent&) {
+        if (has_player_ && entity == player_entity_) {
+          player_removed_ = true;
+        }
+      }));
 
-    auto& body = world.get<components::RigidbodyComponent>(entity);
-    auto& transform = world.get<components::TransformComponent>(entity);
-    transform.setHasPhysics(true);
-    transform.setPhysicsWriteWarning(!body.is_kinematic);
+  const auto& colliders = std::as_const(world).storage<components::ColliderComponent>().denseEntities();
+  pending_.assign(colliders.begin(), colliders.end());
+}
 
-    math::Vec3 teleport_position{};
-    if (body.consumeTeleport(teleport_position)) {
-      teleports_[key] = TeleportRequest{teleport_position, transform.rotation()};
-      body.velocity = {0.0f, 0.0f, 0.0f};
-      body.angular_velocity = {0.0f, 0.0f, 0.0f};
-      continue;
-    }
+void PhysicsSystem::releaseRemoved() {
+  for (const uint64_t key : removed_rigid_) {
+    releaseBody(rigid_bodies_, key);
+  }
+  removed_rigid_.clear();
 
-    if (body.is_kinematic) {
-      if (!it->second.isValid()) {
-        continue;
-      }
-      it->second.setPosition(toGlm(transform.position()));
-      it->second.setRotation(toGlm(transform.rotation()));
-      it->second.setVelocity(toGlm(body.velocity));
-      it->second.setAngularVelocity(toGlm(body.angular_velocity));
-      body.syncPosition(transform.position());
+  for (const uint64_t key : removed_static_) {
+    releaseBody(static_bodies_, key);
+  }
+  removed_static_.clear();
+
+  if (player_removed_) {
+    if (physics_.playerController()) {
+      physics_.playerController()->destroy();
     }
+    has_player_ = false;
+    player_removed_ = false;
   }
+}
 
-  for (const ecs::Entity entity :
-       world.view<components::TransformComponent, components::ColliderComponent>()) {
-    if (world.has<components::RigidbodyComponent>(entity)) {
-      continue;
+void PhysicsSystem::createPendingBodies(ecs::World& world) {
+  const ecs::World& read = world;
+  const auto& matrices = read.storage<components::WorldMatrixComponent>();
+  for (const ecs::Entity entity : pending_) {
+    if (read.isAlive(entity) && !read.has<components::RigidbodyComponent>(entity) &&
+        read.has<components::PreviousTransformComponent>(entity)) {
+      world.remove<components::PreviousTransformComponent>(entity);
     }
-    if (!collisionEnabled(world, entity)) {
+    if (!read.isAlive(entity) || !read.has<components::ColliderComponent>(entity) ||
+        !read.has<components::TransformComponent>(entity)) {
       continue;
     }
-    const auto& collider = world.get<components::ColliderComponent>(entity);
-    if (collider.shape != components::ColliderComponent::Shape::Mesh) {
+    const uint64_t key = entityKey(entity);
+    // Visibility changes queue the entity too; a collider switched off loses
+    // its backend body until it is switched back on.
+    if (!collisionEnabled(read, entity)) {
+      releaseBody(rigid_bodies_, key);
+      releaseBody(static_bodies_, key);
       continue;
     }
-    const uint64_t key = entityKey(entity);
-    if (static_bodies_.find(key) != static_bodies_.end()) {
+    const auto& collider = read.get<components::ColliderComponent>(entity);
+    const auto& transform = read.get<components::TransformComponent>(entity);
+    if (read.has<components::RigidbodyComponent>(entity)) {
+      if (!isBoxCollider(collider) || rigid_bodies_.find(key) != rigid_bodies_.end()) {
+        continue;
+      }
+      const auto& body = read.get<components::RigidbodyComponent>(entity);
+      const components::WorldPose pose = components::worldPose(matrices, entity, transform);
+      PhysicsMaterial material;
+      RigidBody rigid = physics_.createBoxBody(
+          toGlm(collider.half_extents),
+          body.mass,
+          toGlm(pose.position),
+          material);
+      auto it = rigid_bodies_.emplace(key, std::move(rigid)).first;
+      // Also carries velocity over, so a rebuilt dynamic body keeps moving.
+      if (it->second.isValid()) {
+        pushPose(it->second, pose, body);
+        world.get<components::RigidbodyComponent>(entity).syncPosition(pose.position);
+      }
+      if (!body.is_kinematic) {
+        // syncDynamicBodies writes the simulated world pose into the local
+        // transform, which is only right for bodies at the scene root.
+        if (!warned_parented_dynamic_ && !nearPose(pose, transform)) {
+          spdlog::warn("PhysicsSystem: dynamic body {} sits under a transformed scene node; "
+                       "its simulated pose is written as a local transform.",
+                       entity.index);
+          warned_parented_dynamic_ = true;
+        }
+        components::PreviousTransformComponent previous;
+        previous.position = transform.position();
+        previous.rotation = transform.rotation();
+        world.add(entity, previous);
+      }
       continue;
     }
-    if (!world.has<components::MeshComponent>(entity)) {
+    if (collider.shape != components::ColliderComponent::Shape::Mesh ||
+        !read.has<components::MeshComponent>(entity) ||
+        static_bodies_.find(key) != static_bodies_.end()) {
       continue;
     }
-    const auto& mesh = world.get<components::MeshComponent>(entity);
+    const auto& mesh = read.get<components::MeshComponent>(entity);
     StaticBody body = physics_.createStaticMesh(mesh.mesh_key);
     static_bodies_.emplace(key, std::move(body));
   }
+  pending_.clear();
 }
 
-void PhysicsSystem::applyTeleports(ecs::World& world) {
-  for (const auto& [key, teleport] : teleports_) {
+void PhysicsSystem::syncRigidBodies(ecs::World& world, TeleportList& teleports) {
+  const auto& transforms = std::as_const(world).storage<components::TransformComponent>();
+  const auto& bodies = std::as_const(world).storage<components::RigidbodyComponent>();
+  const auto& matrices = std::as_const(world).storage<components::WorldMatrixComponent>();
+  bodyGroup(world).each<const components::TransformComponent, const components::ColliderComponent,
+                        const components::RigidbodyComponent>(
+      [&](ecs::Entity entity, const components::TransformComponent& transform,
+          const components::ColliderComponent& collider, const components::RigidbodyComponent& body) {
+        // Only teleports and kinematic bodies need the backend here. Moving
+        // kinematic bodies are re-posed every step so the backend's integrated
+        // pose cannot drift from the ECS; resting ones only when they change.
+        const bool moving = !sameVec3(body.velocity, {}) || !sameVec3(body.angular_velocity, {});
+        const bool moved = body.is_kinematic &&
+                           (moving || ecs::isNewerTick(bodies.changedTick(entity), last_tick_) ||
+                            ecs::isNewerTick(transforms.changedTick(entity), last_tick_) ||
+                            (matrices.has(entity) &&
+                             ecs::isNewerTick(matrices.changedTick(entity), last_tick_)));
+        if (!moved && !body.hasPendingTeleport()) {
+          return;
+        }
+        if (!collisionEnabled(world, entity)) {
+          return;
+        }
+        if (!isBoxCollider(collider)) {
+          return;
+        }
+
+        const uint64_t key = entityKey(entity);
+        auto it = rigid_bodies_.find(key);
+        if (it == rigid_bodies_.end()) {
+          return;
+        }
+
+        if (body.hasPendingTeleport()) {
+          auto& teleported = world.get<components::RigidbodyComponent>(entity);
+          math::Vec3 teleport_position{};
+          teleported.consumeTeleport(teleport_position);
+          teleports.emplace_back(key, TeleportRequest{teleport_position, transform.rotation()});
+          teleported.velocity = {0.0f, 0.0f, 0.0f};
+          teleported.angular_velocity = {0.0f, 0.0f, 0.0f};
+          return;
+        }
+
+        if (!it->second.isValid()) {
+          return;
+        }
+        const components::WorldPose pose = components::worldPose(matrices, entity, transform);
+        pushPose(it->second, pose, body);
+        world.get<components::RigidbodyComponent>(entity).syncPosition(pose.position);
+      });
+}
+
+void PhysicsSystem::applyTeleports(ecs::World& world, const TeleportList& teleports) {
+  for (const auto& [key, teleport] : teleports) {
     auto it = rigid_bodies_.find(key);
     if (it == rigid_bodies_.end()) {
       continue;
@@ -143,6 +320,12 @@ void PhysicsSystem::applyTeleports(ecs::World& world) {
       transform.setPosition(teleport.position, components::TransformWriteMode::AllowPhysics);
       transform.setRotation(teleport.rotation, components::TransformWriteMode::AllowPhysics);
     }
+    // A teleport is a cut; the renderer must not blend across it.
+    if (world.has<components::PreviousTransformComponent>(entity)) {
+      auto& previous = world.get<components::PreviousTransformComponent>(entity);
+      previous.position = teleport.position;
+      previous.rotation = teleport.rotation;
+    }
     if (world.has<components::RigidbodyComponent>(entity)) {
       auto& body = world.get<components::RigidbodyComponent>(entity);
       body.velocity = {0.0f, 0.0f, 0.0f};
@@ -153,33 +336,56 @@ void PhysicsSystem::applyTeleports(ecs::World& world) {
 }
 
 void PhysicsSystem::syncDynamicBodies(ecs::World& world) {
-  for (const ecs::Entity entity :
-       world.view<components::TransformComponent, components::ColliderComponent, components::RigidbodyComponent>()) {
-    if (!collisionEnabled(world, entity)) {
-      continue;
-    }
-    auto& body = world.get<components::RigidbodyComponent>(entity);
-    if (body.is_kinematic) {
-      continue;
-    }
-    const uint64_t key = entityKey(entity);
-    auto it = rigid_bodies_.find(key);
-    if (it == rigid_bodies_.end()) {
-      continue;
-    }
-    if (!it->second.isValid()) {
-      continue;
-    }
-    auto& transform = world.get<components::TransformComponent>(entity);
-    transform.setPosition(toVec3(it->second.getPosition()),
-                          components::TransformWriteMode::AllowPhysics);
-    transform.setRotation({it->second.getRotation().x, it->second.getRotation().y,
-                           it->second.getRotation().z, it->second.getRotation().w},
-                          components::TransformWriteMode::AllowPhysics);
-    body.velocity = toVec3(it->second.getVelocity());
-    body.angular_velocity = toVec3(it->second.getAngularVelocity());
-    body.syncPosition(transform.position());
-  }
+  auto& transforms = world.storage<components::TransformComponent>();
+  auto& bodies = world.storage<components::RigidbodyComponent>();
+  auto& previous = world.storage<components::PreviousTransformComponent>();
+  world.parallelEach<const components::TransformComponent, const components::RigidbodyComponent>(
+      bodyGroup(world),
+      [&](ecs::Entity entity, const components::TransformComponent& transform,
+          const components::RigidbodyComponent& body) {
+        // The pose this step starts from becomes the previous one. Once a body
+        // rests the two match and the renderer stops blending it.
+        if (previous.has(entity)) {
+          const auto& last = std::as_const(previous).get(entity);
+          if (!sameVec3(last.position, transform.position()) ||
+              !sameQuat(last.rotation, transform.rotation())) {
+            auto& shifted = previous.get(entity);
+            shifted.position = transform.position();
+            shifted.rotation = transform.rotation();
+          }
+        }
+        if (!collisionEnabled(world, entity)) {
+          return;
+        }
+        if (body.is_kinematic) {
+          return;
+        }
+        const uint64_t key = entityKey(entity);
+        auto it = rigid_bodies_.find(key);
+        if (it == rigid_bodies_.end()) {
+          return;
+        }
+        if (!it->second.isValid()) {
+          return;
+        }
+        const math::Vec3 position = toVec3(it->second.getPosition());
+        const glm::quat orientation = it->second.getRotation();
+        const math::Quat rotation{orientation.x, orientation.y, orientation.z, orientation.w};
+        const math::Vec3 velocity = toVec3(it->second.getVelocity());
+        const math::Vec3 angular_velocity = toVec3(it->second.getAngularVelocity());
+        // Leave resting bodies untouched so their change ticks stay old.
+        if (sameVec3(position, transform.position()) && sameQuat(rotation, transform.rotation()) &&
+            sameVec3(velocity, body.velocity) && sameVec3(angular_velocity, body.angular_velocity)) {
+          return;
+        }
+        auto& synced_transform = transforms.get(entity);
+        synced_transform.setPosition(position, components::TransformWriteMode::AllowPhysics);
+        synced_transform.setRotation(rotation, components::TransformWriteMode::AllowPhysics);
+        auto& synced_body = bodies.get(entity);
+        synced_body.velocity = velocity;
+        synced_body.angular_velocity = angular_velocity;
+        synced_body.syncPosition(position);
+      });
 }
 
 void PhysicsSystem::syncPlayerController(ecs::World& world, float dt) {
@@ -225,37 +431,4 @@ void PhysicsSystem::syncPlayerController(ecs::World& world, float dt) {
                         components::TransformWriteMode::AllowPhysics);
 }
 
-void PhysicsSystem::cleanupStale(ecs::World& world) {
-  for (auto it = rigid_bodies_.begin(); it != rigid_bodies_.end();) {
-    ecs::Entity entity = entityFromKey(it->first);
-    if (!world.isAlive(entity) ||
-        !world.has<components::RigidbodyComponent>(entity)) {
-      it->second.destroy();
-      it = rigid_bodies_.erase(it);
-    } else {
-      ++it;
-    }
-  }
-
-  for (auto it = static_bodies_.begin(); it != static_bodies_.end();) {
-    ecs::Entity entity = entityFromKey(it->first);
-    if (!world.isAlive(entity) ||
-        !world.has<components::ColliderComponent>(entity)) {
-      it->second.destroy();
-      it = static_bodies_.erase(it);
-    } else {
-      ++it;
-    }
-  }
-
-  if (has_player_ &&
-      (!world.isAlive(player_entity_) ||
-       !world.has<components::PlayerControllerComponent>(player_entity_))) {
-    if (physics_.playerController()) {
-      physics_.playerController()->destroy();
-    }
-    has_player_ = false;
-  }
-}
-
 }  // namespace karma::physics
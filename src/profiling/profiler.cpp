@@ -0,0 +1,182 @@
+#include "karma/profiling/profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace karma::profiling {
+namespace {
+
+constexpr size_t kEventsPerThread = size_t{1} << 15;
+
+// Fields are relaxed atomics so writeChromeTrace can read a buffer while its
+// thread records; on x86 and ARM they compile to plain loads and stores.
+struct Event {
+  std::atomic<const char*> name{nullptr};
+  std::atomic<uint32_t> name_size{0};
+  std::atomic<uint64_t> begin_ns{0};
+  std::atomic<uint64_t> end_ns{0};
+};
+
+struct ThreadBuffer {
+  std::array<Event, kEventsPerThread> events;
+  // Events ever written; the newest is at (head - 1) % kEventsPerThread.
+  std::atomic<uint64_t> head{0};
+  uint32_t thread_index = 0;
+  std::string name;
+};
+
+struct Registry {
+  std::mutex mutex;
+  // Buffers outlive their threads so zones from finished threads still export.
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  const uint64_t epoch_ns = nowNs();
+};
+
+Registry& registry() {
+  static Registry instance;
+  return instance;
+}
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer& threadBuffer() {
+  if (!t_buffer) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->thread_index = static_cast<uint32_t>(reg.buffers.size());
+    t_buffer = buffer.get();
+    reg.buffers.push_back(std::move(buffer));
+  }
+  return *t_buffer;
+}
+
+void writeEscaped(std::ostream& out, std::string_view text) {
+  for (const char c : text) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+      out << escaped;
+    } else {
+      out << c;
+    }
+  }
+}
+
+// Chrome trace timestamps are microseconds.
+void writeMicros(std::ostream& out, uint64_t ns) {
+  char text[32];
+  std::snprintf(text, sizeof(text), "%llu.%03llu", static_cast<unsigned long long>(ns / 1000),
+                static_cast<unsigned long long>(ns % 1000));
+  out << text;
+}
+
+}  // namespace
+
+uint64_t nowNs() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+void setThreadName(std::string name) {
+  ThreadBuffer& buffer = threadBuffer();
+  std::lock_guard<std::mutex> lock(registry().mutex);
+  buffer.name = std::move(name);
+}
+
+void recordZone(std::string_view name, uint64_t begin_ns, uint64_t end_ns) {
+  ThreadBuffer& buffer = threadBuffer();
+  const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  Event& event = buffer.events[head % kEventsPerThread];
+  event.name.store(name.data(), std::memory_order_relaxed);
+  event.name_size.store(static_cast<uint32_t>(name.size()), std::memory_order_relaxed);
+  event.begin_ns.store(begin_ns, std::memory_order_relaxed);
+  event.end_ns.store(end_ns, std::memory_order_relaxed);
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void writeChromeTrace(std::ostream& out) {
+  struct Snapshot {
+    std::string_view name;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+  };
+
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  std::vector<Snapshot> events;
+  bool first = true;
+  const auto separator = [&] {
+    out << (first ? "\n" : ",\n");
+    first = false;
+  };
+
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  for (const auto& buffer : reg.buffers) {
+    const uint64_t head = buffer->head.load(std::memory_order_acquire);
+    const uint64_t first_index = head > kEventsPerThread ? head - kEventsPerThread : 0;
+    events.clear();
+    for (uint64_t i = first_index; i < head; ++i) {
+      const Event& event = buffer->events[i % kEventsPerThread];
+      events.push_back(Snapshot{
+          std::string_view(event.name.load(std::memory_order_relaxed),
+                           event.name_size.load(std::memory_order_relaxed)),
+          event.begin_ns.load(std::memory_order_relaxed), event.end_ns.load(std::memory_order_relaxed)});
+    }
+    // Slots the thread reused while we copied, including the one it may be
+    // writing now, can be torn; drop them.
+    const uint64_t new_head = buffer->head.load(std::memory_order_acquire);
+    const uint64_t overwritten =
+        new_head + 1 > kEventsPerThread ? std::min(new_head + 1 - kEventsPerThread, head) - first_index : 0;
+
+    if (!buffer->name.empty()) {
+      separator();
+      out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_index
+          << ",\"args\":{\"name\":\"";
+      writeEscaped(out, buffer->name);
+      out << "\"}}";
+    }
+    for (size_t i = static_cast<size_t>(overwritten); i < events.size(); ++i) {
+      const Snapshot& event = events[i];
+      separator();
+      out << "{\"name\":\"";
+      writeEscaped(out, event.name);
+      out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_index << ",\"ts\":";
+      writeMicros(out, event.begin_ns - std::min(event.begin_ns, reg.epoch_ns));
+      out << ",\"dur\":";
+      writeMicros(out, event.end_ns - event.begin_ns);
+      out << "}";
+    }
+  }
+  out << "\n]}\n";
+}
+
+bool writeChromeTrace(const std::filesystem::path& path) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out) {
+    return false;
+  }
+  writeChromeTrace(out);
+  return static_cast<bool>(out);
+}
+
+void clear() {
+  Registry& reg = registry();
+  std::lock_guard<std::mutex> lock(reg.mutex);
+  for (const auto& buffer : reg.buffers) {
+    buffer->head.store(0, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace karma::profiling
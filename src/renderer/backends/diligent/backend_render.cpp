@@ -1,6 +1,7 @@
 #include "karma/renderer/backends/diligent/backend.hpp"
 
 #include "backend_internal.h"
+#include "karma/profiling/profiler.h"
 
 #include <Graphics/GraphicsEngine/interface/DeviceContext.h>
 #include <Graphics/GraphicsEngine/interface/SwapChain.h>
@@ -1317,6 +1318,7 @@ void DiligentBackend::renderSkybox(const glm::mat4& projection, const glm::mat4&
 }
 
 void DiligentBackend::renderLayer(renderer::LayerId layer, renderer::RenderTargetId /*target*/) {
+  KARMA_PROFILE_ZONE("DiligentBackend::renderLayer");
   if (!context_ || !swap_chain_) {
     return;
   }
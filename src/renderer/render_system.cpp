@@ -3,6 +3,7 @@
 #include <glm/gtc/matrix_access.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
 #include <spdlog/spdlog.h>
 #include <algorithm>
 #include <filesystem>
@@ -10,10 +11,15 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <limits>
+#include <utility>
+#include <vector>
 
 #include "karma/components/camera.h"
 #include "karma/components/environment.h"
 #include "karma/components/light.h"
+#include "karma/components/previous_transform.h"
+#include "karma/components/world_matrix.h"
+#include "karma/profiling/profiler.h"
 
 namespace karma::renderer {
 
@@ -26,23 +32,24 @@ glm::quat toGlm(const math::Quat& q) {
   return {q.w, q.x, q.y, q.z};
 }
 
+glm::mat4 toGlm(const math::Mat4& m) {
+  return glm::make_mat4(m.m);
+}
+
 renderer::DirectionalLightData toDirectionalLight(const components::LightComponent& light,
-                                                  const components::TransformComponent& transform) {
+                                                  const components::WorldPose& pose) {
   renderer::DirectionalLightData out{};
   out.color = light.color;
   out.intensity = light.intensity;
-  const glm::quat rot = toGlm(transform.rotation());
+  const glm::quat rot = toGlm(pose.rotation);
   const glm::mat3 basis = glm::mat3_cast(rot);
   out.direction = basis * glm::vec3(0.0f, 0.0f, -1.0f);
-  out.position = toGlm(transform.position());
+  out.position = toGlm(pose.position);
   out.shadow_extent = light.shadow_extent;
   return out;
 }
 
-glm::mat4 toTransform(const components::TransformComponent& transform) {
-  const glm::vec3 pos = toGlm(transform.position());
-  const glm::quat rot = toGlm(transform.rotation());
-  const glm::vec3 scale = toGlm(transform.scale());
+glm::mat4 toTransform(const glm::vec3& pos, const glm::quat& rot, const glm::vec3& scale) {
   glm::mat4 matrix(1.0f);
   matrix = glm::translate(matrix, pos);
   matrix *= glm::mat4_cast(rot);
@@ -50,6 +57,26 @@ glm::mat4 toTransform(const components::TransformComponent& transform) {
   return matrix;
 }
 
+glm::mat4 toTransform(const components::TransformComponent& transform) {
+  return toTransform(toGlm(transform.position()), toGlm(transform.rotation()), toGlm(transform.scale()));
+}
+
+glm::mat4 toTransform(const components::PreviousTransformComponent& previous,
+                      const components::TransformComponent& transform, float alpha) {
+  return toTransform(glm::mix(toGlm(previous.position), toGlm(transform.position()), alpha),
+                     glm::slerp(toGlm(previous.rotation), toGlm(transform.rotation()), alpha),
+                     toGlm(transform.scale()));
+}
+
+bool samePose(const components::PreviousTransformComponent& previous,
+              const components::TransformComponent& transform) {
+  const math::Vec3& p = transform.position();
+  const math::Quat& q = transform.rotation();
+  return previous.position.x == p.x && previous.position.y == p.y && previous.position.z == p.z &&
+         previous.rotation.x == q.x && previous.rotation.y == q.y && previous.rotation.z == q.z &&
+         previous.rotation.w == q.w;
+}
+
 struct FrustumPlanes {
   glm::vec4 planes[6];
 };
@@ -130,187 +157,317 @@ bool computeMeshBounds(const std::string& path, glm::vec3& out_center, float& ou
 }
 
 void RenderSystem::update(ecs::World& world, scene::Scene& /*scene*/, float /*dt*/) {
+  KARMA_PROFILE_ZONE("RenderSystem::update");
+  extract(world, packet_);
+  render(packet_);
+}
+
+void RenderSystem::bind(ecs::World& world, FramePacket& packet) {
+  if (bound_world_ == &world && connections_.front().connected()) {
+    return;
+  }
+  connections_.clear();
+  released_.clear();
+  bound_world_ = &world;
+  // Everything in the new world reads as changed, so the renderer rebuilds its
+  // records from this packet.
+  last_tick_ = 0;
+  packet.reset = true;
+  connections_.push_back(world.onDestroy<components::MeshComponent>().connect(
+      [this](ecs::Entity entity, const components::MeshComponent&) { released_.push_back(entity); }));
+}
+
+void RenderSystem::extract(ecs::World& world, FramePacket& packet, float alpha) {
+  KARMA_PROFILE_ZONE("RenderSystem::extract");
   static bool logged_start = false;
   if (!logged_start) {
     spdlog::warn("Karma: RenderSystem update running.");
     logged_start = true;
   }
-  bool has_camera = false;
-  glm::mat4 projection(1.0f);
-  glm::mat4 view(1.0f);
-  for (const ecs::Entity entity :
-       world.view<components::CameraComponent, components::TransformComponent>()) {
-    const auto& camera = world.get<components::CameraComponent>(entity);
+  packet.clear();
+  bind(world, packet);
+  packet.released.swap(released_);
+
+  // Cameras and lights may hang off scene nodes, so they use the world pose.
+  const auto& matrices = std::as_const(world).storage<components::WorldMatrixComponent>();
+  for (auto [entity, camera, transform] :
+       world.view<const components::CameraComponent, const components::TransformComponent>().each()) {
     if (!camera.is_primary) {
       continue;
     }
-    const auto& transform = world.get<components::TransformComponent>(entity);
+    const components::WorldPose pose = components::worldPose(matrices, entity, transform);
     CameraData cam{};
-    cam.position = toGlm(transform.position());
-    cam.rotation = toGlm(transform.rotation());
+    cam.position = toGlm(pose.position);
+    cam.rotation = toGlm(pose.rotation);
     cam.perspective = true;
     cam.fov_y_degrees = camera.fov_y_degrees;
     cam.aspect = 16.0f / 9.0f;
     cam.near_clip = camera.near_clip;
     cam.far_clip = camera.far_clip;
-    device_.setCamera(cam);
-    projection = glm::perspective(glm::radians(cam.fov_y_degrees),
-                                  cam.aspect,
-                                  cam.near_clip,
-                                  cam.far_clip);
+    const glm::mat4 projection = glm::perspective(glm::radians(cam.fov_y_degrees),
+                                                  cam.aspect,
+                                                  cam.near_clip,
+                                                  cam.far_clip);
     const glm::mat3 cam_basis = glm::mat3_cast(cam.rotation);
     const glm::vec3 forward = cam_basis * glm::vec3(0.0f, 0.0f, -1.0f);
     const glm::vec3 up = cam_basis * glm::vec3(0.0f, 1.0f, 0.0f);
-    view = glm::lookAt(cam.position, cam.position + forward, up);
-    has_camera = true;
+    const glm::mat4 view = glm::lookAt(cam.position, cam.position + forward, up);
+    packet.camera = cam;
+    packet.view_projection = projection * view;
+    packet.has_camera = true;
     break;
   }
 
-  if (!has_camera) {
-    if (!warned_no_camera_) {
-      spdlog::warn("Karma: No primary camera found; rendering a blank frame.");
-      warned_no_camera_ = true;
-    }
-    device_.setCameraActive(false);
-    return;
-  }
-  warned_no_camera_ = false;
-  device_.setCameraActive(true);
-
-  renderer::DirectionalLightData light{};
-  bool has_light = false;
   static bool warned_missing_light_transform = false;
   if (!warned_missing_light_transform) {
-    for (const ecs::Entity entity : world.view<components::LightComponent>()) {
-      if (!world.has<components::TransformComponent>(entity)) {
-        spdlog::warn("Karma: LightComponent entity={} missing TransformComponent.", entityKey(entity));
-        warned_missing_light_transform = true;
-        break;
-      }
+    for (auto [entity, light_component] :
+         world.query<ecs::With<const components::LightComponent>,
+                     ecs::Without<components::TransformComponent>>().each()) {
+      spdlog::warn("Karma: LightComponent entity={} missing TransformComponent.", entityKey(entity));
+      warned_missing_light_transform = true;
+      break;
     }
   }
-  for (const ecs::Entity entity :
-       world.view<components::LightComponent, components::TransformComponent>()) {
-    const auto& light_component = world.get<components::LightComponent>(entity);
+  bool has_light = false;
+  for (auto [entity, light_component, transform] :
+       world.view<const components::LightComponent, const components::TransformComponent>().each()) {
     if (light_component.type != components::LightComponent::Type::Directional) {
       continue;
     }
-    const auto& transform = world.get<components::TransformComponent>(entity);
-    light = toDirectionalLight(light_component, transform);
+    packet.light = toDirectionalLight(light_component, components::worldPose(matrices, entity, transform));
     has_light = true;
     break;
   }
   if (!has_light) {
-    light.direction = glm::vec3(0.3f, 1.0f, 0.2f);
-    light.color = math::Color{1.0f, 1.0f, 1.0f, 1.0f};
-    light.intensity = 1.0f;
+    packet.light.direction = glm::vec3(0.3f, 1.0f, 0.2f);
+    packet.light.color = math::Color{1.0f, 1.0f, 1.0f, 1.0f};
+    packet.light.intensity = 1.0f;
   }
-  device_.setDirectionalLight(light);
 
-  bool env_found = false;
-  for (const ecs::Entity entity : world.view<components::EnvironmentComponent>()) {
-    const auto& env = world.get<components::EnvironmentComponent>(entity);
+  for (auto [entity, env] : world.view<const components::EnvironmentComponent>().each()) {
     if (!env.enabled) {
       continue;
     }
-    if (env.environment_map != last_env_path_ ||
-        env.intensity != last_env_intensity_ ||
-        env.draw_skybox != last_env_draw_skybox_) {
-      device_.setEnvironmentMap(env.environment_map, env.intensity, env.draw_skybox);
-      last_env_path_ = env.environment_map;
-      last_env_intensity_ = env.intensity;
-      last_env_draw_skybox_ = env.draw_skybox;
-    }
-    env_found = true;
+    packet.has_environment = true;
+    packet.environment_map = env.environment_map;
+    packet.environment_intensity = env.intensity;
+    packet.environment_draw_skybox = env.draw_skybox;
     break;
   }
-  if (!env_found &&
-      (!last_env_path_.empty() || last_env_intensity_ >= 0.0f || last_env_draw_skybox_)) {
+
+  const auto& meshes = std::as_const(world).storage<components::MeshComponent>();
+  const auto& transforms = std::as_const(world).storage<components::TransformComponent>();
+  const auto& previous = std::as_const(world).storage<components::PreviousTransformComponent>();
+  alpha = std::clamp(alpha, 0.0f, 1.0f);
+  packet.instances.reserve(meshes.size());
+  for (auto [entity, mesh, transform, visibility] :
+       world.query<ecs::With<const components::MeshComponent, const components::TransformComponent>,
+                   ecs::Optional<const components::VisibilityComponent>>().each()) {
+    // An entity joins the query when the later of its two components arrives.
+    const bool joined = ecs::isNewerTick(meshes.addedTick(entity), last_tick_) ||
+                        ecs::isNewerTick(transforms.addedTick(entity), last_tick_);
+    if (joined || ecs::isNewerTick(meshes.changedTick(entity), last_tick_)) {
+      packet.meshes.push_back(FramePacket::MeshBinding{entity, mesh.mesh_key, mesh.material_key});
+    }
+    FramePacket::Instance& instance = packet.instances.emplace_back();
+    instance.entity = entity;
+    instance.visible = mesh.visible && (!visibility || visibility->visible);
+    instance.moved = joined || ecs::isNewerTick(transforms.changedTick(entity), last_tick_);
+    const bool blended = previous.has(entity);
+    if (blended) {
+      // Mid-step the blended pose moves every frame without any World change.
+      const auto& last = previous.get(entity);
+      instance.moved = instance.moved || ecs::isNewerTick(previous.changedTick(entity), last_tick_) ||
+                       !samePose(last, transform);
+    }
+    // TransformSystem's cached matrix also moves when an ancestor does.
+    const bool cached = !blended && matrices.has(entity);
+    if (cached) {
+      instance.moved = instance.moved || ecs::isNewerTick(matrices.changedTick(entity), last_tick_);
+    }
+    if (instance.moved) {
+      glm::vec3 scale = toGlm(transform.scale());
+      if (cached) {
+        const math::Mat4& matrix = matrices.get(entity).matrix;
+        instance.world_matrix = toGlm(matrix);
+        scale = toGlm(math::basisScale(matrix));
+      } else {
+        instance.world_matrix =
+            blended ? toTransform(previous.get(entity), transform, alpha) : toTransform(transform);
+      }
+      instance.max_scale = std::max(scale.x, std::max(scale.y, scale.z));
+    }
+  }
+  last_tick_ = world.currentTick();
+  world.advanceTick();
+}
+
+void RenderSystem::render(const FramePacket& packet) {
+  KARMA_PROFILE_ZONE("RenderSystem::render");
+  if (packet.reset) {
+    for (const ecs::Entity entity : std::vector<ecs::Entity>(records_.denseEntities())) {
+      releaseRecord(entity);
+    }
+  }
+  for (const ecs::Entity entity : packet.released) {
+    releaseRecord(entity);
+  }
+  for (const FramePacket::MeshBinding& binding : packet.meshes) {
+    const size_t index = records_.find(binding.entity);
+    if (index == ecs::ComponentStorage<RenderRecord>::npos) {
+      createRecord(binding);
+      continue;
+    }
+    RenderRecord& record = records_.at(index);
+    if (record.mesh_key != binding.mesh_key) {
+      const bool exists = !binding.mesh_key.empty() && std::filesystem::exists(binding.mesh_key);
+      spdlog::warn("Karma: RenderSystem mesh changed entity={} mesh='{}' exists={}",
+                   entityKey(binding.entity),
+                   binding.mesh_key,
+                   exists);
+      loadMesh(record, binding.mesh_key);
+      record.dirty = true;
+      spdlog::warn("Karma: RenderSystem updated mesh id={} for entity={}",
+                   record.mesh,
+                   entityKey(binding.entity));
+    }
+  }
+  // Cache moved transforms even on frames that draw nothing; later packets
+  // only carry matrices that changed again.
+  for (const FramePacket::Instance& instance : packet.instances) {
+    if (!instance.moved) {
+      continue;
+    }
+    const size_t index = records_.find(instance.entity);
+    if (index == ecs::ComponentStorage<RenderRecord>::npos) {
+      continue;
+    }
+    RenderRecord& record = records_.at(index);
+    record.world_matrix = instance.world_matrix;
+    record.max_scale = instance.max_scale;
+    record.dirty = true;
+  }
+
+  if (!packet.has_camera) {
+    if (!warned_no_camera_) {
+      spdlog::warn("Karma: No primary camera found; rendering a blank frame.");
+      warned_no_camera_ = true;
+    }
+    device_.setCameraActive(false);
+    return;
+  }
+  warned_no_camera_ = false;
+  device_.setCamera(packet.camera);
+  device_.setCameraActive(true);
+  device_.setDirectionalLight(packet.light);
+
+  if (packet.has_environment) {
+    if (packet.environment_map != last_env_path_ ||
+        packet.environment_intensity != last_env_intensity_ ||
+        packet.environment_draw_skybox != last_env_draw_skybox_) {
+      device_.setEnvironmentMap(packet.environment_map, packet.environment_intensity,
+                                packet.environment_draw_skybox);
+      last_env_path_ = packet.environment_map;
+      last_env_intensity_ = packet.environment_intensity;
+      last_env_draw_skybox_ = packet.environment_draw_skybox;
+    }
+  } else if (!last_env_path_.empty() || last_env_intensity_ >= 0.0f || last_env_draw_skybox_) {
     device_.setEnvironmentMap({}, 0.0f, false);
     last_env_path_.clear();
     last_env_intensity_ = -1.0f;
     last_env_draw_skybox_ = false;
   }
 
-  const FrustumPlanes frustum = extractFrustumPlanes(projection * view);
-
-  for (const ecs::Entity entity :
-       world.view<components::MeshComponent, components::TransformComponent>()) {
-    const auto& mesh = world.get<components::MeshComponent>(entity);
-    const auto& transform = world.get<components::TransformComponent>(entity);
-
-    bool visible = mesh.visible;
-    if (world.has<components::VisibilityComponent>(entity)) {
-      visible = visible && world.get<components::VisibilityComponent>(entity).visible;
+  const FrustumPlanes frustum = extractFrustumPlanes(packet.view_projection);
+  for (const FramePacket::Instance& instance : packet.instances) {
+    const size_t index = records_.find(instance.entity);
+    if (index == ecs::ComponentStorage<RenderRecord>::npos) {
+      continue;
     }
-
-    const uint64_t key = entityKey(entity);
-    auto it = records_.find(key);
-    if (it == records_.end()) {
-      const bool exists = !mesh.mesh_key.empty() && std::filesystem::exists(mesh.mesh_key);
-      spdlog::warn("Karma: RenderSystem create record entity={} mesh='{}' exists={} material='{}'",
-                   key,
-                   mesh.mesh_key,
-                   exists,
-                   mesh.material_key);
-      RenderRecord record;
-      record.mesh_key = mesh.mesh_key;
-      record.material_key = mesh.material_key;
-      record.mesh = device_.createMeshFromFile(mesh.mesh_key);
-      record.material = kInvalidMaterial;
-      auto bounds_it = bounds_cache_.find(mesh.mesh_key);
-      if (bounds_it == bounds_cache_.end()) {
-        MeshBounds bounds{};
-        bounds.valid = computeMeshBounds(mesh.mesh_key, bounds.center, bounds.radius);
-        bounds_it = bounds_cache_.emplace(mesh.mesh_key, bounds).first;
-      }
-      record.bounds_valid = bounds_it->second.valid;
-      record.bounds_center = bounds_it->second.center;
-      record.bounds_radius = bounds_it->second.radius;
-      it = records_.emplace(key, std::move(record)).first;
-      spdlog::warn("Karma: RenderSystem created mesh id={} for entity={}", it->second.mesh, key);
-    } else if (it->second.mesh_key != mesh.mesh_key) {
-      const bool exists = !mesh.mesh_key.empty() && std::filesystem::exists(mesh.mesh_key);
-      spdlog::warn("Karma: RenderSystem mesh changed entity={} mesh='{}' exists={}",
-                   key,
-                   mesh.mesh_key,
-                   exists);
-      it->second.mesh_key = mesh.mesh_key;
-      it->second.mesh = device_.createMeshFromFile(mesh.mesh_key);
-      auto bounds_it = bounds_cache_.find(mesh.mesh_key);
-      if (bounds_it == bounds_cache_.end()) {
-        MeshBounds bounds{};
-        bounds.valid = computeMeshBounds(mesh.mesh_key, bounds.center, bounds.radius);
-        bounds_it = bounds_cache_.emplace(mesh.mesh_key, bounds).first;
-      }
-      it->second.bounds_valid = bounds_it->second.valid;
-      it->second.bounds_center = bounds_it->second.center;
-      it->second.bounds_radius = bounds_it->second.radius;
-      spdlog::warn("Karma: RenderSystem updated mesh id={} for entity={}", it->second.mesh, key);
+    RenderRecord& record = records_.at(index);
+    if (record.dirty) {
+      record.world_center = glm::vec3(record.world_matrix * glm::vec4(record.bounds_center, 1.0f));
+      record.world_radius = record.bounds_radius * record.max_scale;
     }
-
-    const glm::mat4 world_matrix = toTransform(transform);
     bool in_frustum = true;
-    if (it->second.bounds_valid) {
-      const glm::vec3 world_center = glm::vec3(world_matrix * glm::vec4(it->second.bounds_center, 1.0f));
-      const glm::vec3 scale = toGlm(transform.scale());
-      const float max_scale = std::max(scale.x, std::max(scale.y, scale.z));
-      const float world_radius = it->second.bounds_radius * max_scale;
-      if (!sphereInFrustum(frustum, world_center, world_radius)) {
-        in_frustum = false;
-      }
+    if (record.bounds_valid && !sphereInFrustum(frustum, record.world_center, record.world_radius)) {
+      in_frustum = false;
     }
 
+    // The backend keeps instances between frames; only resubmit what changed.
+    const bool item_visible = instance.visible && in_frustum;
+    if (record.submitted && !record.dirty && record.visible == item_visible &&
+        record.shadow_visible == instance.visible) {
+      continue;
+    }
+    record.submitted = true;
+    record.dirty = false;
+    record.visible = item_visible;
+    record.shadow_visible = instance.visible;
+
     DrawItem item{};
-    item.instance = static_cast<InstanceId>(key);
-    item.mesh = it->second.mesh;
-    item.material = it->second.material;
-    item.transform = world_matrix;
+    item.instance = static_cast<InstanceId>(entityKey(instance.entity));
+    item.mesh = record.mesh;
+    item.material = record.material;
+    item.transform = record.world_matrix;
     item.layer = 0;
-    item.visible = visible && in_frustum;
-    item.shadow_visible = visible;
+    item.visible = item_visible;
+    item.shadow_visible = instance.visible;
     device_.submit(item);
   }
 }
 
+void RenderSystem::createRecord(const FramePacket::MeshBinding& binding) {
+  const bool exists = !binding.mesh_key.empty() && std::filesystem::exists(binding.mesh_key);
+  spdlog::warn("Karma: RenderSystem create record entity={} mesh='{}' exists={} material='{}'",
+               entityKey(binding.entity),
+               binding.mesh_key,
+               exists,
+               binding.material_key);
+  RenderRecord record;
+  record.material_key = binding.material_key;
+  record.material = kInvalidMaterial;
+  loadMesh(record, binding.mesh_key);
+  spdlog::warn("Karma: RenderSystem created mesh id={} for entity={}", record.mesh, entityKey(binding.entity));
+  records_.add(binding.entity, std::move(record));
+}
+
+void RenderSystem::loadMesh(RenderRecord& record, const std::string& mesh_key) {
+  record.mesh_key = mesh_key;
+  record.mesh = device_.createMeshFromFile(mesh_key);
+  auto bounds_it = bounds_cache_.find(mesh_key);
+  if (bounds_it == bounds_cache_.end()) {
+    MeshBounds bounds{};
+    bounds.valid = computeMeshBounds(mesh_key, bounds.center, bounds.radius);
+    bounds_it = bounds_cache_.emplace(mesh_key, bounds).first;
+  }
+  record.bounds_valid = bounds_it->second.valid;
+  record.bounds_center = bounds_it->second.center;
+  record.bounds_radius = bounds_it->second.radius;
+}
+
+// Hides the backend instance and frees the entity's mesh.
+void RenderSystem::releaseRecord(ecs::Entity entity) {
+  const size_t index = records_.find(entity);
+  if (index == ecs::ComponentStorage<RenderRecord>::npos) {
+    return;
+  }
+  const RenderRecord& record = std::as_const(records_).at(index);
+  if (record.submitted) {
+    DrawItem item{};
+    item.instance = static_cast<InstanceId>(entityKey(entity));
+    item.mesh = record.mesh;
+    item.material = record.material;
+    item.transform = record.world_matrix;
+    item.layer = 0;
+    item.visible = false;
+    item.shadow_visible = false;
+    device_.submit(item);
+  }
+  if (record.mesh != kInvalidMesh) {
+    device_.destroyMesh(record.mesh);
+  }
+  records_.remove(entity);
+}
+
 }  // namespace karma::renderer
@@ -0,0 +1,173 @@
+#include "karma/scene/scene.h"
+
+namespace karma::scene {
+
+NodeId Scene::createNode(core::EntityId entity) {
+  changed();
+  NodeId id = 0;
+  if (!free_list_.empty()) {
+    id = free_list_.back();
+    free_list_.pop_back();
+  } else {
+    id = static_cast<NodeId>(nodes_.size());
+    nodes_.emplace_back();
+  }
+  nodes_[id] = Node{};
+  nodes_[id].id = id;
+  nodes_[id].entity = entity;
+  return id;
+}
+
+void Scene::destroyNode(NodeId id) {
+  if (!isAlive(id)) {
+    return;
+  }
+  changed();
+  detachFromParent(id);
+  for (NodeId child = nodes_[id].first_child; child != Node::kInvalidId;) {
+    Node& node = nodes_[child];
+    child = node.next_sibling;
+    node.parent = Node::kInvalidId;
+    node.next_sibling = Node::kInvalidId;
+    node.prev_sibling = Node::kInvalidId;
+  }
+  nodes_[id] = Node{};
+  free_list_.push_back(id);
+}
+
+bool Scene::reparent(NodeId child, NodeId new_parent) {
+  if (!isAlive(child)) {
+    return false;
+  }
+  const bool has_parent = isAlive(new_parent);
+  if (has_parent && isAncestorOrSelf(child, new_parent)) {
+    return false;
+  }
+  changed();
+  detachFromParent(child);
+  if (!has_parent) {
+    return true;
+  }
+  Node& node = nodes_[child];
+  Node& parent = nodes_[new_parent];
+  node.parent = new_parent;
+  node.prev_sibling = parent.last_child;
+  if (parent.last_child != Node::kInvalidId) {
+    nodes_[parent.last_child].next_sibling = child;
+  } else {
+    parent.first_child = child;
+  }
+  parent.last_child = child;
+  return true;
+}
+
+void Scene::setEntity(NodeId id, core::EntityId entity) {
+  if (!isAlive(id)) {
+    return;
+  }
+  // The order is unaffected, so a valid sort is patched rather than redone.
+  ++revision_;
+  nodes_[id].entity = entity;
+  if (sorted_valid_) {
+    sorted_.entities[positions_[id]] = entity;
+  }
+}
+
+bool Scene::isAncestorOrSelf(NodeId ancestor, NodeId id) const {
+  for (; id != Node::kInvalidId; id = nodes_[id].parent) {
+    if (id == ancestor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Scene::detachFromParent(NodeId id) {
+  Node& node = nodes_[id];
+  if (node.parent != Node::kInvalidId) {
+    Node& parent = nodes_[node.parent];
+    if (node.prev_sibling != Node::kInvalidId) {
+      nodes_[node.prev_sibling].next_sibling = node.next_sibling;
+    } else {
+      parent.first_child = node.next_sibling;
+    }
+    if (node.next_sibling != Node::kInvalidId) {
+      nodes_[node.next_sibling].prev_sibling = node.prev_sibling;
+    } else {
+      parent.last_child = node.prev_sibling;
+    }
+  }
+  node.parent = Node::kInvalidId;
+  node.next_sibling = Node::kInvalidId;
+  node.prev_sibling = Node::kInvalidId;
+}
+
+// Walks each root's subtree through the child and sibling links without a
+// stack: descend to the first child, otherwise move to the next sibling,
+// climbing until one exists.
+const SortedHierarchy& Scene::sorted() const {
+  if (sorted_valid_) {
+    return sorted_;
+  }
+  SortedHierarchy& out = sorted_;
+  out.nodes.clear();
+  out.parents.clear();
+  out.subtree_end.clear();
+  out.depths.clear();
+  out.entities.clear();
+  const size_t live = nodes_.size() - free_list_.size();
+  out.nodes.reserve(live);
+  out.parents.reserve(live);
+  out.subtree_end.reserve(live);
+  out.depths.reserve(live);
+  out.entities.reserve(live);
+
+  std::vector<uint32_t>& position = positions_;
+  position.assign(nodes_.size(), SortedHierarchy::kNoParent);
+  const auto emit = [&](NodeId id, uint32_t depth) {
+    const Node& node = nodes_[id];
+    position[id] = static_cast<uint32_t>(out.nodes.size());
+    out.nodes.push_back(id);
+    out.parents.push_back(node.parent != Node::kInvalidId ? position[node.parent]
+                                                          : SortedHierarchy::kNoParent);
+    out.subtree_end.push_back(0);
+    out.depths.push_back(depth);
+    out.entities.push_back(node.entity);
+  };
+
+  for (NodeId root = 0; root < nodes_.size(); ++root) {
+    if (!isAlive(root) || nodes_[root].parent != Node::kInvalidId) {
+      continue;
+    }
+    NodeId id = root;
+    uint32_t depth = 0;
+    emit(id, depth);
+    while (true) {
+      if (nodes_[id].first_child != Node::kInvalidId) {
+        id = nodes_[id].first_child;
+        emit(id, ++depth);
+        continue;
+      }
+      while (true) {
+        out.subtree_end[position[id]] = static_cast<uint32_t>(out.nodes.size());
+        if (id == root) {
+          break;
+        }
+        if (nodes_[id].next_sibling != Node::kInvalidId) {
+          id = nodes_[id].next_sibling;
+          emit(id, depth);
+          break;
+        }
+        id = nodes_[id].parent;
+        --depth;
+      }
+      if (id == root) {
+        break;
+      }
+    }
+  }
+  sorted_valid_ = true;
+  return out;
+}
+
+}  // namespace karma::scene
@@ -0,0 +1,229 @@
+#include "karma/systems/system_graph.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "karma/profiling/profiler.h"
+#include "karma/tasks/scheduler.h"
+
+namespace karma::systems {
+namespace {
+
+// Weight of the newest sample in each system's moving average cost.
+constexpr float kCostSmoothing = 0.125f;
+
+}  // namespace
+
+SystemGraph::SystemGraph(tasks::Scheduler* scheduler) : scheduler_(scheduler) {}
+
+SystemId SystemGraph::addSystem(std::unique_ptr<ISystem> system) {
+  Node node;
+  node.system = std::move(system);
+  nodes_.push_back(std::move(node));
+  order_valid_ = false;
+  return static_cast<SystemId>(nodes_.size());
+}
+
+void SystemGraph::addDependency(SystemId system, SystemId depends_on) {
+  if (!contains(system) || !contains(depends_on)) {
+    throw std::invalid_argument("SystemGraph::addDependency: unknown system id.");
+  }
+  nodes_[depends_on - 1].dependents.push_back(system - 1);
+  ++nodes_[system - 1].dependency_count;
+  order_valid_ = false;
+}
+
+void SystemGraph::update(ecs::World& world, float dt) {
+  KARMA_PROFILE_ZONE("SystemGraph::update");
+  if (!order_valid_) {
+    buildOrder();
+    buildSchedule();
+  }
+  if (has_parallelism_) {
+    tasks::Scheduler& scheduler = scheduler_ ? *scheduler_ : tasks::scheduler();
+    if (scheduler.workerCount() > 0) {
+      runParallel(world, dt, scheduler);
+      return;
+    }
+  }
+  for (uint32_t index : order_) {
+    if (nodes_[index].system) {
+      KARMA_PROFILE_ZONE(nodes_[index].system->name());
+      nodes_[index].system->update(world, dt);
+    }
+  }
+}
+
+// Kahn's algorithm; order_ doubles as the FIFO ready queue.
+void SystemGraph::buildOrder() {
+  std::vector<uint32_t> pending(nodes_.size());
+  order_.clear();
+  order_.reserve(nodes_.size());
+  for (uint32_t index = 0; index < nodes_.size(); ++index) {
+    pending[index] = nodes_[index].dependency_count;
+    if (pending[index] == 0) {
+      order_.push_back(index);
+    }
+  }
+  for (size_t head = 0; head < order_.size(); ++head) {
+    for (uint32_t dependent : nodes_[order_[head]].dependents) {
+      if (--pending[dependent] == 0) {
+        order_.push_back(dependent);
+      }
+    }
+  }
+
+  if (order_.size() != nodes_.size()) {
+    std::string names;
+    for (uint32_t index = 0; index < nodes_.size(); ++index) {
+      if (pending[index] != 0) {
+        names += names.empty() ? "" : ", ";
+        names += nodes_[index].system ? std::string(nodes_[index].system->name()) : "<null>";
+      }
+    }
+    order_.clear();
+    throw std::logic_error("SystemGraph: dependency cycle; unscheduled systems: " + names + ".");
+  }
+  order_valid_ = true;
+}
+
+// Orders every conflicting pair the way the serial order_ does; since order_
+// is topological, the added edges cannot form a cycle.
+void SystemGraph::buildSchedule() {
+  std::vector<SystemAccess> access(nodes_.size());
+  for (uint32_t index = 0; index < nodes_.size(); ++index) {
+    Node& node = nodes_[index];
+    node.successors = node.dependents;
+    node.predecessor_count = node.dependency_count;
+    if (node.system) {
+      access[index] = node.system->access();
+    }
+  }
+  for (size_t i = 0; i < order_.size(); ++i) {
+    Node& earlier = nodes_[order_[i]];
+    for (size_t j = i + 1; j < order_.size(); ++j) {
+      if (access[order_[i]].conflictsWith(access[order_[j]])) {
+        earlier.successors.push_back(order_[j]);
+        ++nodes_[order_[j]].predecessor_count;
+      }
+    }
+  }
+
+  // Two systems can overlap exactly when some neighbours in the topological
+  // order have no edge between them.
+  has_parallelism_ = false;
+  for (size_t i = 0; i + 1 < order_.size(); ++i) {
+    const auto& successors = nodes_[order_[i]].successors;
+    if (std::find(successors.begin(), successors.end(), order_[i + 1]) == successors.end()) {
+      has_parallelism_ = true;
+      break;
+    }
+  }
+  run_.ready.reserve(nodes_.size());
+  run_.pending.resize(nodes_.size());
+}
+
+// Priority is a system's cost plus the costliest chain of systems behind it.
+void SystemGraph::updatePriorities() {
+  for (auto it = order_.rbegin(); it != order_.rend(); ++it) {
+    Node& node = nodes_[*it];
+    float longest = 0.0f;
+    for (uint32_t successor : node.successors) {
+      longest = std::max(longest, nodes_[successor].priority);
+    }
+    node.priority = node.cost_ns + longest;
+  }
+}
+
+void SystemGraph::runParallel(ecs::World& world, float dt, tasks::Scheduler& scheduler) {
+  updatePriorities();
+  run_.world = &world;
+  run_.dt = dt;
+  run_.scheduler = &scheduler;
+  run_.error = nullptr;
+  run_.ready.clear();
+  for (uint32_t index = 0; index < nodes_.size(); ++index) {
+    run_.pending[index] = nodes_[index].predecessor_count;
+    if (run_.pending[index] == 0) {
+      run_.ready.push_back(index);
+    }
+  }
+
+  run_.max_lanes = std::min<size_t>(scheduler.workerCount() + 1, nodes_.size());
+  {
+    std::lock_guard<std::mutex> lock(run_.mutex);
+    run_.lanes = 1;
+    spawnLanes(std::min(run_.max_lanes, run_.ready.size()) - 1);
+  }
+  runLane();
+  scheduler.wait(run_.group);
+  if (run_.error) {
+    std::rethrow_exception(std::exchange(run_.error, nullptr));
+  }
+}
+
+// Called with run_.mutex held.
+void SystemGraph::spawnLanes(size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    ++run_.lanes;
+    run_.scheduler->submit(run_.group, &SystemGraph::laneTask, this);
+  }
+}
+
+void SystemGraph::laneTask(void* graph) {
+  static_cast<SystemGraph*>(graph)->runLane();
+}
+
+// A lane takes the highest-priority ready system until none is ready or one
+// has failed. Lanes never wait for systems to become ready: the lane that
+// finishes a system runs what it released and starts extra lanes for the rest,
+// so idle workers stay free for other tasks.
+void SystemGraph::runLane() {
+  std::unique_lock<std::mutex> lock(run_.mutex);
+  for (;;) {
+    if (run_.error || run_.ready.empty()) {
+      --run_.lanes;
+      return;
+    }
+    const auto best = std::max_element(run_.ready.begin(), run_.ready.end(), [this](uint32_t a, uint32_t b) {
+      return nodes_[a].priority < nodes_[b].priority;
+    });
+    const uint32_t index = *best;
+    *best = run_.ready.back();
+    run_.ready.pop_back();
+    lock.unlock();
+
+    Node& node = nodes_[index];
+    std::exception_ptr error;
+    const auto start = std::chrono::steady_clock::now();
+    if (node.system) {
+      KARMA_PROFILE_ZONE(node.system->name());
+      try {
+        node.system->update(*run_.world, run_.dt);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    const float elapsed_ns =
+        std::chrono::duration<float, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    lock.lock();
+    node.cost_ns += (elapsed_ns - node.cost_ns) * kCostSmoothing;
+    if (error && !run_.error) {
+      run_.error = error;
+    }
+    for (uint32_t successor : node.successors) {
+      if (--run_.pending[successor] == 0) {
+        run_.ready.push_back(successor);
+      }
+    }
+    if (run_.ready.size() > 1 && run_.lanes < run_.max_lanes) {
+      spawnLanes(std::min(run_.ready.size() - 1, run_.max_lanes - run_.lanes));
+    }
+  }
+}
+
+}  // namespace karma::systems
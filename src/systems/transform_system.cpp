@@ -0,0 +1,171 @@
+#include "karma/systems/transform_system.h"
+
+#include "karma/profiling/profiler.h"
+
+namespace karma::systems {
+namespace {
+
+math::Mat4 localMatrix(const components::TransformComponent& transform) {
+  return math::composeTRS(transform.position(), transform.rotation(), transform.scale());
+}
+
+}  // namespace
+
+void TransformSystem::update(ecs::World& world, float /*dt*/) {
+  KARMA_PROFILE_ZONE("TransformSystem::update");
+  bind(world);
+  if (!built_ || scene_revision_ != scene_.revision()) {
+    rebuild(world);
+  }
+  const scene::SortedHierarchy& hierarchy = scene_.sorted();
+
+  const ecs::World& read = world;
+  for (const ecs::Entity entity : removed_) {
+    if (read.isAlive(entity) && !read.has<components::TransformComponent>(entity) &&
+        read.has<components::WorldMatrixComponent>(entity)) {
+      world.remove<components::WorldMatrixComponent>(entity);
+    }
+    // Children of a node that lost its transform now hang off its parent.
+    const uint32_t slot = slotOf(entity);
+    if (slot != kNone) {
+      markDirty(hierarchy, slot);
+    }
+  }
+  removed_.clear();
+
+  // Declared access lets this run beside other systems, which rules out
+  // advanceTick(). Writes stamped with the tick of the previous update are
+  // therefore taken again, so those made after it in the same tick are not
+  // missed; entities written before it are recomputed twice.
+  const ecs::Tick since = last_tick_ - 1;
+  const auto& transforms = read.storage<components::TransformComponent>();
+  for (const ecs::Entity entity : transforms.denseEntities()) {
+    if (!ecs::isNewerTick(transforms.changedTick(entity), since)) {
+      continue;
+    }
+    const uint32_t slot = slotOf(entity);
+    if (slot != kNone) {
+      markDirty(hierarchy, slot);
+    } else {
+      store(world, entity, localMatrix(transforms.get(entity)));
+    }
+  }
+
+  // Parents precede their children, so they are final when a child reads them.
+  const auto count = static_cast<uint32_t>(entities_.size());
+  for (uint32_t i = 0; i < count;) {
+    const uint32_t parent = hierarchy.parents[i];
+    const bool parent_moved = parent != kNone && (flags_[parent] & kMoved) != 0;
+    if ((flags_[i] & kDirty) == 0 && !parent_moved) {
+      i = (flags_[i] & kBelow) == 0 ? hierarchy.subtree_end[i] : i + 1;
+      continue;
+    }
+    const ecs::Entity entity = entities_[i];
+    if (read.isAlive(entity) && transforms.has(entity)) {
+      const math::Mat4 local = localMatrix(transforms.get(entity));
+      matrices_[i] = parent != kNone ? math::mul(matrices_[parent], local) : local;
+      store(world, entity, matrices_[i]);
+    } else {
+      matrices_[i] = parent != kNone ? matrices_[parent] : math::Mat4{};
+    }
+    setFlags(i, kMoved);
+    ++i;
+  }
+
+  for (const uint32_t slot : touched_) {
+    flags_[slot] = 0;
+  }
+  touched_.clear();
+  last_tick_ = world.currentTick();
+}
+
+void TransformSystem::bind(ecs::World& world) {
+  if (bound_world_ == &world && connections_.front().connected()) {
+    return;
+  }
+  connections_.clear();
+  removed_.clear();
+  bound_world_ = &world;
+  last_tick_ = 0;
+  built_ = false;
+  connections_.push_back(world.onDestroy<components::TransformComponent>().connect(
+      [this](ecs::Entity entity, const components::TransformComponent&) { removed_.push_back(entity); }));
+}
+
+void TransformSystem::rebuild(ecs::World& world) {
+  for (const ecs::Entity entity : entities_) {
+    if (entity.isValid()) {
+      slot_of_[entity.index] = kNone;
+    }
+  }
+  std::vector<ecs::Entity> previous;
+  previous.swap(entities_);
+
+  const scene::SortedHierarchy& hierarchy = scene_.sorted();
+  entities_.assign(hierarchy.entities.begin(), hierarchy.entities.end());
+  for (uint32_t slot = 0; slot < entities_.size(); ++slot) {
+    const ecs::Entity entity = entities_[slot];
+    if (!entity.isValid()) {
+      continue;
+    }
+    if (entity.index >= slot_of_.size()) {
+      slot_of_.resize(entity.index + 1, kNone);
+    }
+    slot_of_[entity.index] = slot;
+  }
+
+  matrices_.resize(entities_.size());
+  flags_.assign(entities_.size(), 0);
+  touched_.clear();
+  // The structure changed, so every node is recomputed once.
+  for (uint32_t slot = 0; slot < entities_.size(); ++slot) {
+    setFlags(slot, kDirty);
+  }
+  scene_revision_ = scene_.revision();
+  built_ = true;
+
+  // Entities that left the hierarchy fall back to their local transform.
+  const ecs::World& read = world;
+  for (const ecs::Entity entity : previous) {
+    if (entity.isValid() && slotOf(entity) == kNone && read.isAlive(entity) &&
+        read.has<components::TransformComponent>(entity)) {
+      store(world, entity, localMatrix(read.get<components::TransformComponent>(entity)));
+    }
+  }
+}
+
+uint32_t TransformSystem::slotOf(ecs::Entity entity) const {
+  if (entity.index >= slot_of_.size()) {
+    return kNone;
+  }
+  const uint32_t slot = slot_of_[entity.index];
+  return slot != kNone && entities_[slot] == entity ? slot : kNone;
+}
+
+void TransformSystem::markDirty(const scene::SortedHierarchy& hierarchy, uint32_t slot) {
+  setFlags(slot, kDirty);
+  for (uint32_t parent = hierarchy.parents[slot]; parent != kNone && (flags_[parent] & kBelow) == 0;
+       parent = hierarchy.parents[parent]) {
+    setFlags(parent, kBelow);
+  }
+}
+
+void TransformSystem::setFlags(uint32_t slot, uint8_t flags) {
+  if (flags_[slot] == 0) {
+    touched_.push_back(slot);
+  }
+  flags_[slot] |= flags;
+}
+
+void TransformSystem::store(ecs::World& world, ecs::Entity entity, const math::Mat4& matrix) {
+  auto& matrices = world.storage<components::WorldMatrixComponent>();
+  if (matrices.has(entity)) {
+    matrices.get(entity).matrix = matrix;
+  } else {
+    components::WorldMatrixComponent component;
+    component.matrix = matrix;
+    world.add(entity, component);
+  }
+}
+
+}  // namespace karma::systems
@@ -0,0 +1,70 @@
+#include "karma/tasks/background_job.h"
+
+#include <stdexcept>
+#include <utility>
+
+#include "karma/profiling/profiler.h"
+
+namespace karma::tasks {
+
+BackgroundJob::~BackgroundJob() {
+  if (!thread_.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+}
+
+void BackgroundJob::run(JobFn fn, void* context) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (busy_) {
+      throw std::logic_error("BackgroundJob::run: the previous job is still running.");
+    }
+    job_ = fn;
+    context_ = context;
+    busy_ = true;
+  }
+  if (!thread_.joinable()) {
+    thread_ = std::thread([this] { loop(); });
+  }
+  wake_.notify_one();
+}
+
+void BackgroundJob::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return !busy_; });
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+}
+
+void BackgroundJob::loop() {
+  KARMA_PROFILE_THREAD("Background job");
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return stopping_ || job_; });
+    if (!job_) {
+      return;
+    }
+    const JobFn job = std::exchange(job_, nullptr);
+    void* context = std::exchange(context_, nullptr);
+    lock.unlock();
+    std::exception_ptr error;
+    try {
+      job(context);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    lock.lock();
+    error_ = error;
+    busy_ = false;
+    done_.notify_all();
+  }
+}
+
+}  // namespace karma::tasks
@@ -0,0 +1,331 @@
+#include "karma/tasks/scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "karma/profiling/profiler.h"
+
+namespace karma::tasks {
+namespace {
+
+// The pool and queue index of the calling thread when it is a worker.
+thread_local const Scheduler* t_scheduler = nullptr;
+thread_local size_t t_worker = 0;
+
+struct ForBatch {
+  const Scheduler::RangeFn* func = nullptr;
+  size_t count = 0;
+  size_t chunk_size = 0;
+  size_t chunk_count = 0;
+  std::atomic<size_t> next_chunk{0};
+};
+
+void runChunks(void* context) {
+  auto& batch = *static_cast<ForBatch*>(context);
+  for (;;) {
+    const size_t chunk = batch.next_chunk.fetch_add(1, std::memory_order_relaxed);
+    if (chunk >= batch.chunk_count) {
+      return;
+    }
+    const size_t begin = chunk * batch.chunk_size;
+    (*batch.func)(begin, std::min(batch.count, begin + batch.chunk_size), chunk);
+  }
+}
+
+}  // namespace
+
+TaskGraph::TaskId TaskGraph::add(std::function<void()> func) {
+  nodes_.emplace_back().func = std::move(func);
+  validated_ = false;
+  return static_cast<TaskId>(nodes_.size() - 1);
+}
+
+void TaskGraph::precede(TaskId before, TaskId after) {
+  if (before >= nodes_.size() || after >= nodes_.size()) {
+    throw std::invalid_argument("TaskGraph::precede: unknown task id.");
+  }
+  nodes_[before].successors.push_back(after);
+  ++nodes_[after].predecessor_count;
+  validated_ = false;
+}
+
+Scheduler::Scheduler(unsigned worker_count) {
+  workers_.reserve(worker_count);
+  for (unsigned i = 0; i < worker_count; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i]->thread = std::thread([this, i] { workerLoop(i); });
+  }
+}
+
+Scheduler::~Scheduler() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stopping_.store(true);
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+unsigned Scheduler::defaultWorkerCount() {
+  const unsigned hardware = std::thread::hardware_concurrency();
+  return hardware > 1 ? hardware - 1 : 0;
+}
+
+void Scheduler::submit(TaskGroup& group, TaskFn fn, void* context) {
+  group.pending_.fetch_add(1, std::memory_order_relaxed);
+  if (workers_.empty()) {
+    // Nobody else would pick it up; run it now so callers need not wait().
+    execute(Task{fn, context, &group});
+    return;
+  }
+  push(Task{fn, context, &group});
+}
+
+void Scheduler::wait(TaskGroup& group) {
+  while (!group.done()) {
+    Task task;
+    if (pop(task)) {
+      execute(task);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  if (group.failed_.load(std::memory_order_acquire)) {
+    group.failed_.store(false, std::memory_order_relaxed);
+    std::rethrow_exception(std::exchange(group.error_, nullptr));
+  }
+}
+
+void Scheduler::parallelFor(size_t count, size_t chunk_size, const RangeFn& func) {
+  if (count == 0) {
+    return;
+  }
+  chunk_size = std::max<size_t>(chunk_size, 1);
+  const size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+  if (chunk_count == 1 || workers_.empty()) {
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+      const size_t begin = chunk * chunk_size;
+      func(begin, std::min(count, begin + chunk_size), chunk);
+    }
+    return;
+  }
+
+  ForBatch batch;
+  batch.func = &func;
+  batch.count = count;
+  batch.chunk_size = chunk_size;
+  batch.chunk_count = chunk_count;
+  TaskGroup group;
+  const size_t helpers = std::min<size_t>(workers_.size(), chunk_count - 1);
+  for (size_t i = 0; i < helpers; ++i) {
+    submit(group, &runChunks, &batch);
+  }
+
+  // Helpers reference batch, so they must finish even if this thread throws.
+  std::exception_ptr error;
+  try {
+    runChunks(&batch);
+  } catch (...) {
+    error = std::current_exception();
+    batch.next_chunk.store(chunk_count, std::memory_order_relaxed);
+  }
+  if (error) {
+    try {
+      wait(group);
+    } catch (...) {
+    }
+    std::rethrow_exception(error);
+  }
+  wait(group);
+}
+
+void Scheduler::run(TaskGraph& graph) {
+  const size_t size = graph.nodes_.size();
+  if (!graph.validated_) {
+    std::vector<uint32_t> pending(size);
+    std::vector<TaskGraph::TaskId> ready;
+    for (TaskGraph::TaskId id = 0; id < size; ++id) {
+      pending[id] = graph.nodes_[id].predecessor_count;
+      if (pending[id] == 0) {
+        ready.push_back(id);
+      }
+    }
+    size_t visited = 0;
+    while (!ready.empty()) {
+      const TaskGraph::TaskId id = ready.back();
+      ready.pop_back();
+      ++visited;
+      for (TaskGraph::TaskId successor : graph.nodes_[id].successors) {
+        if (--pending[successor] == 0) {
+          ready.push_back(successor);
+        }
+      }
+    }
+    if (visited != size) {
+      throw std::logic_error("Scheduler::run: the task graph contains a cycle.");
+    }
+    graph.launches_.resize(size);
+    for (TaskGraph::TaskId id = 0; id < size; ++id) {
+      graph.launches_[id] = TaskGraph::Launch{&graph, id};
+    }
+    graph.validated_ = true;
+  }
+
+  TaskGroup group;
+  graph.scheduler_ = this;
+  graph.group_ = &group;
+  for (auto& node : graph.nodes_) {
+    node.pending.store(node.predecessor_count, std::memory_order_relaxed);
+  }
+  for (TaskGraph::TaskId id = 0; id < size; ++id) {
+    if (graph.nodes_[id].predecessor_count == 0) {
+      submit(group, &runGraphTask, &graph.launches_[id]);
+    }
+  }
+  wait(group);
+}
+
+// A task whose func throws does not release its successors; they are skipped
+// and Scheduler::run rethrows.
+void Scheduler::runGraphTask(void* context) {
+  const auto& launch = *static_cast<const TaskGraph::Launch*>(context);
+  TaskGraph& graph = *launch.graph;
+  TaskGraph::Node& node = graph.nodes_[launch.task];
+  if (node.func) {
+    node.func();
+  }
+  for (TaskGraph::TaskId successor : node.successors) {
+    if (graph.nodes_[successor].pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      graph.scheduler_->submit(*graph.group_, &runGraphTask, &graph.launches_[successor]);
+    }
+  }
+}
+
+void Scheduler::execute(const Task& task) {
+  try {
+    task.fn(task.context);
+  } catch (...) {
+    if (!task.group->failed_.exchange(true, std::memory_order_acq_rel)) {
+      task.group->error_ = std::current_exception();
+    }
+  }
+  task.group->pending_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void Scheduler::push(const Task& task) {
+  if (t_scheduler == this) {
+    Worker& worker = *workers_[t_worker];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.pushBack(task);
+  } else {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    shared_tasks_.pushBack(task);
+  }
+  queued_.fetch_add(1);
+  if (sleepers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wake_.notify_one();
+  }
+}
+
+bool Scheduler::pop(Task& out) {
+  if (queued_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  const bool is_worker = t_scheduler == this;
+  if (is_worker) {
+    Worker& worker = *workers_[t_worker];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      out = worker.tasks.popBack();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared_mutex_);
+    if (!shared_tasks_.empty()) {
+      out = shared_tasks_.popFront();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  return steal(is_worker ? t_worker : workers_.size(), out);
+}
+
+// Scans the other workers' queues starting after the thief's own.
+bool Scheduler::steal(size_t thief, Task& out) {
+  const size_t count = workers_.size();
+  for (size_t offset = 1; offset <= count; ++offset) {
+    const size_t victim = (thief + offset) % count;
+    if (victim == thief) {
+      continue;
+    }
+    Worker& worker = *workers_[victim];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (!worker.tasks.empty()) {
+      out = worker.tasks.popFront();
+      queued_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void Scheduler::TaskQueue::pushBack(const Task& task) {
+  if (size_ == slots_.size()) {
+    std::vector<Task> grown(std::max<size_t>(slots_.size() * 2, 64));
+    for (size_t i = 0; i < size_; ++i) {
+      grown[i] = slots_[(head_ + i) % slots_.size()];
+    }
+    slots_.swap(grown);
+    head_ = 0;
+  }
+  slots_[(head_ + size_) % slots_.size()] = task;
+  ++size_;
+}
+
+Scheduler::Task Scheduler::TaskQueue::popBack() {
+  --size_;
+  return slots_[(head_ + size_) % slots_.size()];
+}
+
+Scheduler::Task Scheduler::TaskQueue::popFront() {
+  const Task task = slots_[head_];
+  head_ = (head_ + 1) % slots_.size();
+  --size_;
+  return task;
+}
+
+void Scheduler::workerLoop(size_t index) {
+  t_scheduler = this;
+  t_worker = index;
+  KARMA_PROFILE_THREAD("Worker " + std::to_string(index));
+  for (;;) {
+    Task task;
+    if (pop(task)) {
+      execute(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleepers_.fetch_add(1);
+    wake_.wait(lock, [this] { return queued_.load() > 0 || stopping_.load(); });
+    sleepers_.fetch_sub(1);
+    if (stopping_.load() && queued_.load() == 0) {
+      return;
+    }
+  }
+}
+
+Scheduler& scheduler() {
+  static Scheduler instance;
+  return instance;
+}
+
+}  // namespace karma::tasks